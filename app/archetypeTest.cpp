@@ -0,0 +1,172 @@
+#include "test.hpp"
+#include <map>
+
+// Entities move between archetypes as components are added and removed, several of them out of
+// one table at once. Every entity keeps its values and its location, also after reopening the
+// instance, which rebuilds the entities from the archetype tables.
+namespace {
+    using test::check;
+    using test::expect;
+
+    struct Expected {
+        bool health;
+        bool mass;
+    };
+
+    uint32_t healthOf(DdsEntity entity) {
+        return static_cast<uint32_t>(entity * 10);
+    }
+
+    double massOf(DdsEntity entity) {
+        return static_cast<double>(entity) / 2;
+    }
+
+    // the cell of the column named name in the row, false if the table has no such column
+    bool cell(DdsInstance instance, DdsId table, DdsId row, char const *name, DdsDataType type,
+            void *pValue, DdsSize size) {
+        DdsId const *pColumns;
+        DdsSize columnCount;
+        check(ddsGetTableColumns(instance, table, &pColumns, &columnCount), "ddsGetTableColumns");
+        for (size_t i = 0; i != columnCount; ++i) {
+            char const *pName;
+            check(ddsGetColumnName(instance, pColumns[i], &pName), "ddsGetColumnName");
+            if (std::strcmp(pName, name) != 0) {
+                continue;
+            }
+
+            DdsColumnData data;
+            check(ddsColumnData(instance, pColumns[i], type, &data), "ddsColumnData");
+            expect(row < data.size / data.stride, "the row of an entity in its table");
+            std::memcpy(pValue, data.pData + row * data.stride, size);
+            return true;
+        }
+        return false;
+    }
+
+    void expectEntities(DdsInstance instance, std::map<DdsEntity, Expected> const &expected,
+            std::vector<DdsEntity> const &destroyed) {
+        size_t rows = 0;
+        DdsSize tableCount;
+        check(ddsGetTablesCount(instance, &tableCount), "ddsGetTablesCount");
+        for (DdsId table = 0; table != tableCount; ++table) {
+            DdsId const *pColumns;
+            DdsSize columnCount;
+            check(ddsGetTableColumns(instance, table, &pColumns, &columnCount),
+                    "ddsGetTableColumns");
+            rows += test::values(instance, pColumns[0]).size();
+        }
+        expect(rows == expected.size(), "one row per entity");
+
+        for (auto const &[entity, components] : expected) {
+            DdsId table, row;
+            check(ddsGetEntity(instance, entity, &table, &row), "ddsGetEntity");
+
+            DdsEntity stored;
+            expect(cell(instance, table, row, "entity", DDS_UINT64_TYPE, &stored, sizeof(stored)),
+                    "an entity column");
+            expect(stored == entity, "the row of the entity");
+
+            uint32_t health;
+            bool hasHealth = cell(instance, table, row, "health", DDS_UINT32_TYPE, &health,
+                    sizeof(health));
+            expect(hasHealth == components.health, "the health component");
+            expect(!hasHealth || health == healthOf(entity), "the health of the entity");
+
+            double mass;
+            bool hasMass = cell(instance, table, row, "mass", DDS_DOUBLE_TYPE, &mass,
+                    sizeof(mass));
+            expect(hasMass == components.mass, "the mass component");
+            expect(!hasMass || mass == massOf(entity), "the mass of the entity");
+        }
+
+        for (DdsEntity entity : destroyed) {
+            DdsId table, row;
+            expect(ddsGetEntity(instance, entity, &table, &row) == DDS_RESULT_VALUE_NOT_EXIST,
+                    "no destroyed entity");
+        }
+    }
+
+    void addMass(DdsInstance instance, DdsId mass, std::vector<DdsEntity> const &entities) {
+        std::vector<double> values;
+        for (DdsEntity entity : entities) {
+            values.push_back(massOf(entity));
+        }
+        check(ddsAddComponent(instance, entities.size(), entities.data(), mass, values.data()),
+                "ddsAddComponent");
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_archetype_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+
+    DdsId health, mass;
+    check(ddsRegisterComponent(instance, "health", DDS_UINT32_TYPE, &health),
+            "ddsRegisterComponent");
+    check(ddsRegisterComponent(instance, "mass", DDS_DOUBLE_TYPE, &mass), "ddsRegisterComponent");
+
+    std::vector<uint32_t> healths;
+    for (DdsEntity entity = 0; entity != 10; ++entity) {
+        healths.push_back(healthOf(entity));
+    }
+    void const *pValues[] = {healths.data()};
+    std::vector<DdsEntity> created(healths.size());
+    check(ddsCreateEntities(instance, created.size(), 1, &health, pValues, created.data()),
+            "ddsCreateEntities");
+    expect(created == std::vector<DdsEntity>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, "entities in order");
+
+    std::map<DdsEntity, Expected> expected;
+    for (DdsEntity entity : created) {
+        expected[entity] = {true, false};
+    }
+
+    // the last rows of the table are among the moved ones and fill the gaps of others
+    addMass(instance, mass, {1, 8, 3, 9, 5});
+    for (DdsEntity entity : {1, 3, 5, 8, 9}) {
+        expected[entity].mass = true;
+    }
+    expectEntities(instance, expected, {});
+
+    std::vector<DdsEntity> moved{3, 9, 5};
+    check(ddsRemoveComponent(instance, moved.size(), moved.data(), health),
+            "ddsRemoveComponent");
+    for (DdsEntity entity : moved) {
+        expected[entity].health = false;
+    }
+    expectEntities(instance, expected, {});
+
+    std::vector<DdsEntity> destroyed{0, 9, 6, 8};
+    check(ddsDestroyEntities(instance, destroyed.size(), destroyed.data()), "ddsDestroyEntities");
+    for (DdsEntity entity : destroyed) {
+        expected.erase(entity);
+    }
+    expectEntities(instance, expected, destroyed);
+
+    expect(ddsDestroyEntities(instance, 1, &destroyed[0]) == DDS_RESULT_VALUE_NOT_EXIST,
+            "no destroy of a destroyed entity");
+    expect(ddsRemoveComponent(instance, 1, &created[2], mass) == DDS_RESULT_COLUMN_NOT_EXIST,
+            "no removal of a missing component");
+
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    ddsDeleteInstance(instance);
+
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+    expectEntities(instance, expected, destroyed);
+
+    // components are found by name and new entities take ids after the largest one left
+    check(ddsRegisterComponent(instance, "mass", DDS_DOUBLE_TYPE, &mass), "ddsRegisterComponent");
+    double newMass = massOf(8);
+    pValues[0] = &newMass;
+    DdsEntity entity;
+    check(ddsCreateEntities(instance, 1, 1, &mass, pValues, &entity), "ddsCreateEntities");
+    expect(entity == 8, "the next entity id");
+    expected[entity] = {false, true};
+    expectEntities(instance, expected, {0, 6, 9});
+
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "test.hpp"
+#include <algorithm>
+
+// One flush removes rows of three tables connected in two levels. Positions are recorded before
+// the flush, some of them in rows that the cascade from a removed parent moves.
+namespace {
+    using test::check;
+    using test::expect;
+
+    struct Table {
+        DdsId id;
+        DdsId idColumn;
+        DdsId parentColumn;
+    };
+
+    Table createChild(DdsInstance instance, char const *name, std::vector<uint64_t> const &ids,
+            std::vector<uint64_t> const &parents) {
+        Table table{};
+        auto columns = test::createTable(instance, name, {"id", "parent"},
+                {DDS_UINT64_TYPE, DDS_UINT64_TYPE}, &table.id);
+        table.idColumn = columns[0];
+        table.parentColumn = columns[1];
+
+        DdsDataType types[] = {DDS_UINT64_TYPE, DDS_UINT64_TYPE};
+        DdsData data[] = {
+                {reinterpret_cast<uint8_t const *>(ids.data()), ids.size() * sizeof(uint64_t)},
+                {reinterpret_cast<uint8_t const *>(parents.data()),
+                        parents.size() * sizeof(uint64_t)},
+        };
+        check(ddsInsert(instance, table.id, ids.size(), 2, types, data), "ddsInsert");
+        return table;
+    }
+
+    // ids of the rows left, sorted
+    std::vector<uint64_t> ids(DdsInstance instance, DdsId column) {
+        std::vector<uint64_t> result = test::values(instance, column);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    // pairs of child id and the id of its parent row
+    std::vector<std::pair<uint64_t, uint64_t>> links(DdsInstance instance, Table const &child,
+            DdsId parentIdColumn) {
+        std::vector<uint64_t> childIds = test::values(instance, child.idColumn);
+        std::vector<uint64_t> parents = test::values(instance, child.parentColumn);
+        std::vector<uint64_t> parentIds = test::values(instance, parentIdColumn);
+
+        std::vector<std::pair<uint64_t, uint64_t>> result;
+        for (size_t i = 0; i != childIds.size(); ++i) {
+            expect(parents[i] < parentIds.size(), "children of existing parents only");
+            result.emplace_back(childIds[i], parentIds[parents[i]]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_cascade_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+
+    DdsId top;
+    DdsId topIds = test::createTable(instance, "top", {"id"}, {DDS_UINT64_TYPE}, &top)[0];
+    test::insert(instance, top, {100, 101, 102});
+    Table middle = createChild(instance, "middle", {200, 201, 202, 203, 204}, {0, 1, 0, 2, 1});
+    Table leaf = createChild(instance, "leaf", {300, 301, 302, 303, 304, 305, 306, 307},
+            {0, 1, 2, 3, 4, 0, 2, 3});
+    check(ddsMakeConnection(instance, top, middle.parentColumn, DDS_CONNECTION_MULTI),
+            "ddsMakeConnection");
+    check(ddsMakeConnection(instance, middle.id, leaf.parentColumn, DDS_CONNECTION_MULTI),
+            "ddsMakeConnection");
+
+    // top 100 takes middle 200 and 202 and leaves 300, 302, 305 and 306 along, middle 204 takes
+    // leaf 304, leaf 307 goes on its own
+    check(ddsRecordRemove(instance, top, 0, 0), "ddsRecordRemove");
+    check(ddsRecordRemove(instance, leaf.id, 0, 7), "ddsRecordRemove");
+    check(ddsRecordRemove(instance, middle.id, 0, 4), "ddsRecordRemove");
+    check(ddsRecordRemove(instance, leaf.id, 0, 0), "ddsRecordRemove");
+    check(ddsFlushCommands(instance), "ddsFlushCommands");
+
+    expect(ids(instance, topIds) == std::vector<uint64_t>{101, 102}, "the top rows left");
+    expect(ids(instance, middle.idColumn) == std::vector<uint64_t>{201, 203},
+            "the middle rows left");
+    expect(ids(instance, leaf.idColumn) == std::vector<uint64_t>{301, 303}, "the leaf rows left");
+    expect(links(instance, middle, topIds) ==
+            std::vector<std::pair<uint64_t, uint64_t>>{{201, 101}, {203, 102}},
+            "the middle rows under their parents");
+    expect(links(instance, leaf, middle.idColumn) ==
+            std::vector<std::pair<uint64_t, uint64_t>>{{301, 201}, {303, 203}},
+            "the leaf rows under their parents");
+
+    expect(ddsRemove(instance, leaf.id, 2) == DDS_RESULT_INVALID_DATA,
+            "no removal past the last row");
+
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
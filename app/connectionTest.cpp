@@ -0,0 +1,196 @@
+#include "test.hpp"
+#include <algorithm>
+
+// Children of every parent through single and multi connections while parents and children are
+// inserted and removed, with more parents than children and parents without any.
+namespace {
+    using test::check;
+    using test::expect;
+
+    // the children of every parent are exactly the rows of the child table pointing at it
+    void expectChildren(DdsInstance instance, DdsId parentTable, DdsId column) {
+        DdsSize parentCount;
+        check(ddsGetTableLength(instance, parentTable, &parentCount), "ddsGetTableLength");
+        std::vector<uint64_t> parents = test::values(instance, column);
+
+        for (DdsId parent = 0; parent != parentCount; ++parent) {
+            std::vector<DdsRowIndex> expected;
+            for (size_t child = 0; child != parents.size(); ++child) {
+                if (parents[child] == parent) {
+                    expected.push_back(child);
+                }
+            }
+
+            DdsRowIndex const *pChildren;
+            DdsSize count;
+            check(ddsFindChildren(instance, column, parent, &pChildren, &count),
+                    "ddsFindChildren");
+            std::vector<DdsRowIndex> children(pChildren, pChildren + count);
+            std::sort(children.begin(), children.end());
+            expect(children == expected, "the children of every parent");
+        }
+        for (uint64_t parent : parents) {
+            expect(parent < parentCount, "children of existing parents only");
+        }
+    }
+
+    void expectChild(DdsInstance instance, DdsId parentTable, DdsId column) {
+        DdsSize parentCount;
+        check(ddsGetTableLength(instance, parentTable, &parentCount), "ddsGetTableLength");
+        std::vector<uint64_t> parents = test::values(instance, column);
+
+        for (DdsId parent = 0; parent != parentCount; ++parent) {
+            auto iter = std::find(parents.begin(), parents.end(), parent);
+            DdsId child;
+            DdsResult result = ddsFindChild(instance, column, parent, &child);
+            if (iter == parents.end()) {
+                expect(result == DDS_RESULT_CHILD_NOT_EXIST, "no child of a parent without one");
+            } else {
+                check(result, "ddsFindChild");
+                expect(child == static_cast<DdsId>(iter - parents.begin()), "the child");
+            }
+        }
+    }
+
+    void multi(DdsInstance instance) {
+        DdsId parentTable, childTable;
+        test::createTable(instance, "parent", {"id"}, {DDS_UINT64_TYPE}, &parentTable);
+        DdsId column = test::createTable(instance, "child", {"parent"}, {DDS_UINT64_TYPE},
+                &childTable)[0];
+
+        // eight parents, three children, parents 1 and 3 to 7 without any
+        test::insert(instance, parentTable, {10, 11, 12, 13, 14, 15, 16, 17});
+        test::insert(instance, childTable, {0, 2, 0});
+        expect(ddsMakeConnection(instance, parentTable, column, DDS_CONNECTION_MULTI) ==
+                DDS_RESULT_SUCCESS, "a connection of more parents than children");
+        expectChildren(instance, parentTable, column);
+
+        test::insert(instance, parentTable, {18, 19});
+        test::insert(instance, childTable, {9, 9, 1, 0, 9, 7});
+        expectChildren(instance, parentTable, column);
+
+        // the last parent moves into the place of the removed one and takes its children along
+        check(ddsRemove(instance, parentTable, 2), "ddsRemove");
+        expectChildren(instance, parentTable, column);
+
+        // parent 0 is left without children, then a parent without children is removed
+        std::vector<uint64_t> parents = test::values(instance, column);
+        for (size_t child = parents.size(); child-- != 0;) {
+            if (parents[child] == 0) {
+                check(ddsRemove(instance, childTable, child), "ddsRemove");
+            }
+        }
+        expectChildren(instance, parentTable, column);
+        check(ddsRemove(instance, parentTable, 5), "ddsRemove");
+        expectChildren(instance, parentTable, column);
+
+        // the last parent itself, with a child
+        check(ddsRemove(instance, parentTable, 7), "ddsRemove");
+        expectChildren(instance, parentTable, column);
+    }
+
+    void single(DdsInstance instance) {
+        DdsId parentTable, childTable;
+        test::createTable(instance, "single_parent", {"id"}, {DDS_UINT64_TYPE}, &parentTable);
+        DdsId column = test::createTable(instance, "single_child", {"parent"},
+                {DDS_UINT64_TYPE}, &childTable)[0];
+
+        test::insert(instance, parentTable, {10, 11, 12, 13, 14, 15});
+        test::insert(instance, childTable, {4, 1});
+        check(ddsMakeConnection(instance, parentTable, column, DDS_CONNECTION_SINGLE),
+                "ddsMakeConnection");
+        expectChild(instance, parentTable, column);
+
+        test::insert(instance, parentTable, {16});
+        test::insert(instance, childTable, {6});
+        expectChild(instance, parentTable, column);
+
+        // the last child goes, then a parent without a child
+        check(ddsRemove(instance, childTable, 2), "ddsRemove");
+        expectChild(instance, parentTable, column);
+        check(ddsRemove(instance, parentTable, 0), "ddsRemove");
+        expectChild(instance, parentTable, column);
+
+        // parent 1 loses its child with it
+        check(ddsRemove(instance, parentTable, 1), "ddsRemove");
+        expectChild(instance, parentTable, column);
+    }
+
+    // the range of every parent holds its children, the lookup never sorts
+    void expectRanges(DdsInstance instance, DdsId parentTable, DdsId column) {
+        DdsSize parentCount;
+        check(ddsGetTableLength(instance, parentTable, &parentCount), "ddsGetTableLength");
+        std::vector<uint64_t> parents = test::values(instance, column);
+
+        for (DdsId parent = 0; parent != parentCount; ++parent) {
+            DdsId offset;
+            DdsSize count;
+            check(ddsFindChildRange(instance, column, parent, &offset, &count),
+                    "ddsFindChildRange");
+            expect(static_cast<size_t>(std::count(parents.begin(), parents.end(), parent)) ==
+                    count, "every child in the range");
+            expect(std::all_of(parents.begin() + offset, parents.begin() + offset + count,
+                    [parent](uint64_t value) { return value == parent; }), "only children");
+        }
+    }
+
+    void cluster(DdsInstance instance) {
+        DdsId parentTable, childTable;
+        test::createTable(instance, "cluster_parent", {"id"}, {DDS_UINT64_TYPE}, &parentTable);
+        DdsId column = test::createTable(instance, "cluster_child", {"parent"},
+                {DDS_UINT64_TYPE}, &childTable)[0];
+
+        test::insert(instance, parentTable, {10, 11, 12, 13});
+        test::insert(instance, childTable, {3, 0, 2, 0, 3, 3});
+        check(ddsMakeConnection(instance, parentTable, column, DDS_CONNECTION_MULTI),
+                "ddsMakeConnection");
+        expect(ddsClusterChildren(instance, childTable, column) == DDS_RESULT_INVALID_DATA,
+                "no cluster of a table that is not the parent");
+        check(ddsClusterChildren(instance, parentTable, column), "ddsClusterChildren");
+        expectRanges(instance, parentTable, column);
+
+        // a change outside of a flush is clustered again explicitly
+        test::insert(instance, childTable, {1, 0});
+        DdsId offset;
+        DdsSize count;
+        expect(ddsFindChildRange(instance, column, 0, &offset, &count) ==
+                DDS_RESULT_INVALID_DATA, "no range of an unsorted cluster");
+        check(ddsClusterChildren(instance, parentTable, column), "ddsClusterChildren");
+        expectRanges(instance, parentTable, column);
+
+        // a flush clusters its whole batch once
+        uint64_t values[] = {2, 1, 3};
+        DdsDataType type = DDS_UINT64_TYPE;
+        DdsData data{reinterpret_cast<uint8_t const *>(values), sizeof(values)};
+        check(ddsRecordInsert(instance, childTable, 0, 3, 1, &type, &data), "ddsRecordInsert");
+        check(ddsRecordRemove(instance, childTable, 0, 0), "ddsRecordRemove");
+        check(ddsFlushCommands(instance), "ddsFlushCommands");
+        expectRanges(instance, parentTable, column);
+    }
+
+    void invalidParent(DdsInstance instance) {
+        DdsId parentTable, childTable;
+        test::createTable(instance, "invalid_parent", {"id"}, {DDS_UINT64_TYPE}, &parentTable);
+        DdsId column = test::createTable(instance, "invalid_child", {"parent"},
+                {DDS_UINT64_TYPE}, &childTable)[0];
+
+        test::insert(instance, parentTable, {10, 11});
+        test::insert(instance, childTable, {1, 2});
+        expect(ddsMakeConnection(instance, parentTable, column, DDS_CONNECTION_MULTI) ==
+                DDS_RESULT_INVALID_DATA, "no connection to a parent that does not exist");
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_connection_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+    multi(instance);
+    single(instance);
+    cluster(instance);
+    invalidParent(instance);
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
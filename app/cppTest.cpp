@@ -0,0 +1,155 @@
+#include "test.hpp"
+#include "dds/cpp/ForEach.hpp"
+#include "dds/cpp/StructTable.hpp"
+#include "dds/cpp/TableView.hpp"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+// The C++ headers over the C API: TableView bound to soa and aos tables, forEach and
+// parallelForEach over both layouts and registerTable on a reflected struct.
+namespace {
+    using test::check;
+    using test::expect;
+
+    // more rows than one chunk of parallelForEach
+    constexpr size_t rowCount = 3 * dds::forEachChunkRows + 5;
+
+    struct Particle {
+        uint32_t id; // padded, a packed table has its mass elsewhere
+        double mass;
+        DdsVec3F position;
+
+        static constexpr char const *columnNames[] = {"id", "mass", "position"};
+    };
+
+    DdsId createAos(DdsInstance instance, DdsTableType type, char const *name,
+            std::vector<char const *> const &columnNames, std::vector<DdsDataType> const &types) {
+        DdsId table;
+        check(ddsCreateTable(instance, type, name, columnNames.size(), columnNames.data(),
+                types.data(), &table), "ddsCreateTable");
+        return table;
+    }
+
+    // ids 0, 1, ... and weights half of them
+    template<typename ViewT>
+    void fill(ViewT &view) {
+        std::vector<uint64_t> ids(rowCount);
+        std::iota(ids.begin(), ids.end(), 0);
+        std::vector<float> weights(rowCount);
+        std::transform(ids.begin(), ids.end(), weights.begin(), [](uint64_t id) {
+            return static_cast<float>(id) / 2;
+        });
+        check(view.insert(rowCount, ids.data(), weights.data()), "TableView::insert");
+    }
+
+    // forEach and parallelForEach over the columns of the table in order
+    void forEachRows(DdsInstance instance, DdsId table) {
+        uint64_t idSum = 0;
+        check(dds::forEach<uint64_t const, float const>(instance, table,
+                [&idSum](uint64_t const &id, float const &) {
+                    idSum += id;
+                }), "forEach");
+        expect(idSum == uint64_t{rowCount} * (rowCount - 1) / 2, "every row visited once");
+
+        std::atomic<size_t> visited{0};
+        check(dds::parallelForEach<uint64_t const, float>(instance, table,
+                [&visited](uint64_t const &id, float &weight) {
+                    weight = static_cast<float>(id);
+                    ++visited;
+                }), "parallelForEach");
+        expect(visited == rowCount, "every row visited once in parallel");
+
+        // by name, in another order
+        char const *names[] = {"weight", "id"};
+        bool written = true;
+        check(dds::forEach<float const, uint64_t const>(instance, table, names,
+                [&written](float const &weight, uint64_t const &id) {
+                    written = written && weight == static_cast<float>(id);
+                }), "forEach");
+        expect(written, "the weights written in parallel");
+
+        expect(dds::forEach<float, float>(instance, table, [](float &, float &) {}) ==
+                DDS_RESULT_INVALID_TYPE, "no forEach over columns of other types");
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_cpp_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+
+    // soa view
+    DdsId soa;
+    test::createTable(instance, "soa", {"id", "weight"}, {DDS_UINT64_TYPE, DDS_FLOAT_TYPE}, &soa);
+    dds::TableView<dds::SoaLayout, uint64_t, float> soaView;
+    check(soaView.bind(instance, soa), "TableView::bind");
+    fill(soaView);
+    expect(soaView.size() == rowCount, "the inserted rows");
+    expect(soaView.get<1>()[10] == 5.0f, "a soa cell");
+    DdsId position;
+    check(soaView.find<0>(uint64_t{1234}, &position), "TableView::find");
+    expect(position == 1234, "the row of a found id");
+    expect(dds::TableView<dds::SoaLayout, uint64_t, double>{}.bind(instance, soa) ==
+            DDS_RESULT_INVALID_TYPE, "no view of other column types");
+    expect(dds::TableView<dds::AosLayout, uint64_t, float>{}.bind(instance, soa) ==
+            DDS_RESULT_INVALID_TYPE, "no aos view of a soa table");
+
+    // aos view, its columns are strided ranges
+    DdsId aos = createAos(instance, DDS_TABLE_AOS, "aos", {"id", "weight"},
+            {DDS_UINT64_TYPE, DDS_FLOAT_TYPE});
+    dds::TableView<dds::AosLayout, uint64_t, float> aosView;
+    check(aosView.bind(instance, aos), "TableView::bind");
+    fill(aosView);
+    auto ids = aosView.get<0>();
+    expect(ids.size() == rowCount && ids[rowCount - 1] == rowCount - 1, "an aos cell");
+    expect(std::lower_bound(ids.begin(), ids.end(), 1234) - ids.begin() == 1234,
+            "a binary search over a strided column");
+    expect(std::is_sorted(ids.begin(), ids.end()), "ids in insert order");
+    check(aosView.remove(0), "TableView::remove");
+    expect(aosView.size() == rowCount - 1 && aosView.get<0>()[0] == rowCount - 1,
+            "the last row moved into the removed one");
+    check(aosView.insertRow(0, 0.0f), "TableView::insertRow");
+    expect(dds::TableView<dds::SoaLayout, uint64_t, float>{}.bind(instance, aos) ==
+            DDS_RESULT_INVALID_TYPE, "no soa view of an aos table");
+
+    forEachRows(instance, soa);
+    forEachRows(instance, aos);
+
+    // reflected struct
+    dds::StructTable<Particle> particles;
+    check(dds::registerTable(instance, "particles", &particles), "registerTable");
+    std::vector<Particle> rows{{1, 1.5, {1, 2, 3}}, {2, 2.5, {4, 5, 6}}, {3, 3.5, {7, 8, 9}}};
+    check(particles.insert(rows.data(), rows.size()), "StructTable::insert");
+    check(particles.remove(0), "StructTable::remove");
+
+    // registering again binds the existing table
+    dds::StructTable<Particle> bound;
+    check(dds::registerTable(instance, "particles", &bound), "registerTable");
+    expect(bound.id() == particles.id(), "the existing table");
+    dds::Span<Particle> span;
+    check(bound.rows(&span), "StructTable::rows");
+    expect(span.size() == 2 && span[0].id == 3 && span[0].mass == 3.5 &&
+            span[0].position.z == 9 && span[1].id == 2, "the rows as structs");
+
+    DdsId mass;
+    check(ddsGetColumn(instance, particles.id(), "mass", &mass), "ddsGetColumn");
+    DdsColumnData masses;
+    check(ddsColumnData(instance, mass, DDS_DOUBLE_TYPE, &masses), "ddsColumnData");
+    expect(masses.stride == sizeof(Particle) &&
+            *reinterpret_cast<double const *>(masses.pData) == 3.5, "a column of the struct");
+
+    // same names and types, members at other offsets
+    createAos(instance, DDS_TABLE_AOS_PACK, "packed", {"id", "mass", "position"},
+            {DDS_UINT32_TYPE, DDS_DOUBLE_TYPE, DDS_VEC3F_TYPE});
+    dds::StructTable<Particle> packed;
+    expect(dds::registerTable(instance, "packed", &packed) == DDS_RESULT_INVALID_DATA,
+            "no struct over a table of another layout");
+    expect(dds::registerTable(instance, "aos", &packed) == DDS_RESULT_INVALID_TYPE,
+            "no struct over a table of other columns");
+
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
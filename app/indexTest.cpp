@@ -0,0 +1,83 @@
+#include "test.hpp"
+
+// ddsFind keeps finding the first row of a value held by several rows after removes and updates
+// of some of them
+namespace {
+    using test::check;
+    using test::expect;
+
+    constexpr uint64_t x = 10;
+    constexpr uint64_t y = 20;
+    constexpr uint64_t z = 30;
+
+    // row of value, DDS_RESULT_VALUE_NOT_EXIST as row count + 1
+    DdsId find(DdsInstance instance, DdsId column, uint64_t value) {
+        DdsId position;
+        DdsResult result = ddsFind(instance, column, DDS_UINT64_TYPE, &value, &position);
+        if (result == DDS_RESULT_VALUE_NOT_EXIST) {
+            return test::values(instance, column).size() + 1;
+        }
+        check(result, "ddsFind");
+        return position;
+    }
+
+    void update(DdsInstance instance, DdsId column, DdsId position, uint64_t value) {
+        check(ddsRecordUpdate(instance, column, 0, position, DDS_UINT64_TYPE, &value),
+                "ddsRecordUpdate");
+        check(ddsFlushCommands(instance), "ddsFlushCommands");
+    }
+
+    DdsId createRows(DdsInstance instance, char const *name, std::vector<uint64_t> const &rows,
+            DdsId *pTable) {
+        DdsId column = test::createTable(instance, name, {"value"}, {DDS_UINT64_TYPE}, pTable)[0];
+        test::insert(instance, *pTable, rows);
+        return column;
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_index_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+
+    // the last x moves into the removed first one
+    DdsId table;
+    DdsId column = createRows(instance, "removeFirst", {x, y, x}, &table);
+    expect(find(instance, column, x) == 0, "the first x");
+    check(ddsRemove(instance, table, 0), "ddsRemove");
+    expect(find(instance, column, x) == 0, "the x moved to the removed row");
+    expect(find(instance, column, y) == 1, "y in place");
+    check(ddsRemove(instance, table, 0), "ddsRemove");
+    expect(find(instance, column, x) == 2, "no x left");
+
+    // a later x is removed and y moves in front of the first x
+    column = createRows(instance, "removeLater", {y, x, x, y, z}, &table);
+    expect(find(instance, column, x) == 1, "the first x");
+    check(ddsRemove(instance, table, 0), "ddsRemove");
+    expect(find(instance, column, z) == 0, "z moved to the removed row");
+    expect(find(instance, column, y) == 3, "the y left");
+    check(ddsRemove(instance, table, 1), "ddsRemove");
+    expect(find(instance, column, y) == 1, "y moved in front of the x left");
+    expect(find(instance, column, x) == 2, "the x left");
+
+    // updates away from and onto duplicate values
+    column = createRows(instance, "update", {x, y, x, y}, &table);
+    update(instance, column, 0, z);
+    expect(find(instance, column, x) == 2, "the x left after an update");
+    expect(find(instance, column, z) == 0, "the updated row");
+    update(instance, column, 3, z);
+    expect(find(instance, column, z) == 0, "z stays at its first row");
+    expect(find(instance, column, y) == 1, "the y left");
+    update(instance, column, 1, x);
+    expect(find(instance, column, x) == 1, "x moves to an earlier row");
+    expect(find(instance, column, y) == 5, "no y left");
+    update(instance, column, 1, x);
+    update(instance, column, 2, y);
+    expect(find(instance, column, x) == 1, "x kept by the other row");
+    expect(find(instance, column, y) == 2, "the updated y");
+
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
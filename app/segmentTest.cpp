@@ -0,0 +1,59 @@
+#include "test.hpp"
+
+// A segmented instance mapped with MMAP_WRITE is updated in place and closed without a
+// checkpoint, then opened again.
+namespace {
+    using test::check;
+    using test::expect;
+
+    constexpr DdsInstanceCreateFlags mapped = static_cast<DdsInstanceCreateFlags>(
+            DDS_INSTANCE_CREATE_SEGMENTED | DDS_INSTANCE_CREATE_MMAP_WRITE);
+
+    DdsId valueColumn(DdsInstance instance) {
+        DdsId table, column;
+        check(ddsGetTable(instance, "values", &table), "ddsGetTable");
+        check(ddsGetColumn(instance, table, "value", &column), "ddsGetColumn");
+        return column;
+    }
+
+    void update(DdsInstance instance, DdsId position, uint64_t value) {
+        check(ddsRecordUpdate(instance, valueColumn(instance), 0, position, DDS_UINT64_TYPE,
+                &value), "ddsRecordUpdate");
+        check(ddsFlushCommands(instance), "ddsFlushCommands");
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_segment_test");
+    DdsInstance instance;
+
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    DdsId table;
+    test::createTable(instance, "values", {"value"}, {DDS_UINT64_TYPE}, &table);
+    test::insert(instance, table, {1, 2, 3, 4});
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    ddsDeleteInstance(instance);
+
+    // the mapped segment changes behind the checksums of the manifest
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    update(instance, 1, 20);
+    ddsDeleteInstance(instance);
+
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    expect(test::values(instance, valueColumn(instance)) == std::vector<uint64_t>{1, 20, 3, 4},
+            "the update written in place");
+
+    // a checkpoint writes the checksums again, so a copy read into memory is checked
+    update(instance, 2, 30);
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    ddsDeleteInstance(instance);
+
+    check(ddsCreateInstance(DDS_INSTANCE_CREATE_SEGMENTED, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+    expect(test::values(instance, valueColumn(instance)) == std::vector<uint64_t>{1, 20, 30, 4},
+            "the checkpointed values");
+    ddsDeleteInstance(instance);
+
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
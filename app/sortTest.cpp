@@ -0,0 +1,161 @@
+#include "test.hpp"
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+// ddsSortTable by numeric keys, sorted by radix, and by string keys, sorted by merge, in both
+// orders. The sort is stable and ddsFind still finds the first row of every value afterwards.
+namespace {
+    using test::check;
+    using test::expect;
+
+    // enough rows for several chunks of the parallel sorts
+    constexpr size_t rowCount = 200000;
+
+    struct Table {
+        DdsId id;
+        DdsId key; // INT64, many duplicates
+        DdsId name; // STRING16
+        DdsId row; // UINT64, the row position at insert
+    };
+
+    Table createRows(DdsInstance instance) {
+        Table table{};
+        auto columns = test::createTable(instance, "rows", {"key", "name", "row"},
+                {DDS_INT64_TYPE, DDS_STRING16_TYPE, DDS_UINT64_TYPE}, &table.id);
+        table.key = columns[0];
+        table.name = columns[1];
+        table.row = columns[2];
+
+        std::mt19937_64 random(rowCount);
+        std::vector<int64_t> keys(rowCount);
+        std::vector<DdsString16> names(rowCount);
+        std::vector<uint64_t> rows(rowCount);
+        for (size_t i = 0; i != rowCount; ++i) {
+            keys[i] = static_cast<int64_t>(random() % 1000) - 500;
+            std::string name = "n" + std::to_string(random() % 100);
+            names[i] = {};
+            names[i].length = name.size();
+            std::memcpy(names[i].str, name.data(), name.size());
+            rows[i] = i;
+        }
+
+        DdsDataType types[] = {DDS_INT64_TYPE, DDS_STRING16_TYPE, DDS_UINT64_TYPE};
+        DdsData data[] = {
+                {reinterpret_cast<uint8_t const *>(keys.data()), rowCount * sizeof(int64_t)},
+                {reinterpret_cast<uint8_t const *>(names.data()),
+                        rowCount * sizeof(DdsString16)},
+                {reinterpret_cast<uint8_t const *>(rows.data()), rowCount * sizeof(uint64_t)},
+        };
+        check(ddsInsert(instance, table.id, rowCount, 3, types, data), "ddsInsert");
+        return table;
+    }
+
+    std::vector<int64_t> keys(DdsInstance instance, Table const &table) {
+        DdsColumnData data;
+        check(ddsColumnData(instance, table.key, DDS_INT64_TYPE, &data), "ddsColumnData");
+        std::vector<int64_t> result(data.size / data.stride);
+        for (size_t i = 0; i != result.size(); ++i) {
+            std::memcpy(&result[i], data.pData + i * data.stride, sizeof(int64_t));
+        }
+        return result;
+    }
+
+    std::vector<std::string> names(DdsInstance instance, Table const &table) {
+        DdsColumnData data;
+        check(ddsColumnData(instance, table.name, DDS_STRING16_TYPE, &data), "ddsColumnData");
+        std::vector<std::string> result(data.size / data.stride);
+        for (size_t i = 0; i != result.size(); ++i) {
+            DdsString16 name;
+            std::memcpy(&name, data.pData + i * data.stride, sizeof(name));
+            result[i].assign(name.str, name.length);
+        }
+        return result;
+    }
+
+    int compareKeys(int64_t left, int64_t right) {
+        return (left > right) - (left < right);
+    }
+
+    // Sorts and checks that rows of equal keys kept their order, given by the previous position of
+    // each row. makeCompare reads the sorted columns and returns the comparison of two rows.
+    template<typename FnT>
+    void sortStable(DdsInstance instance, Table const &table, std::vector<DdsId> const &keyColumns,
+            DdsSortOrder order, FnT &&makeCompare) {
+        std::vector<uint64_t> rank(rowCount);
+        std::vector<uint64_t> rows = test::values(instance, table.row);
+        for (size_t i = 0; i != rowCount; ++i) {
+            rank[rows[i]] = i;
+        }
+
+        check(ddsSortTable(instance, table.id, keyColumns.size(), keyColumns.data(), order),
+                "ddsSortTable");
+
+        rows = test::values(instance, table.row);
+        auto compare = makeCompare();
+        for (size_t i = 1; i != rowCount; ++i) {
+            int compared = compare(i - 1, i);
+            expect(compared <= 0, "rows in key order");
+            expect(compared != 0 || rank[rows[i - 1]] < rank[rows[i]], "a stable sort");
+        }
+    }
+
+    // the first row of every key and the row of every unique value
+    void expectFind(DdsInstance instance, Table const &table) {
+        std::vector<int64_t> keyValues = keys(instance, table);
+        std::unordered_map<int64_t, DdsId> first;
+        for (size_t i = 0; i != rowCount; ++i) {
+            first.try_emplace(keyValues[i], i);
+        }
+        for (auto [key, row] : first) {
+            DdsId position;
+            check(ddsFind(instance, table.key, DDS_INT64_TYPE, &key, &position), "ddsFind");
+            expect(position == row, "the first row of a duplicate key");
+        }
+
+        std::vector<uint64_t> rows = test::values(instance, table.row);
+        for (size_t i = 0; i < rowCount; i += 97) {
+            DdsId position;
+            check(ddsFind(instance, table.row, DDS_UINT64_TYPE, &rows[i], &position), "ddsFind");
+            expect(position == i, "the row of a unique value");
+        }
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_sort_test");
+    DdsInstance instance;
+    check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+            "ddsCreateInstance");
+    Table table = createRows(instance);
+
+    // the indices are built before the sorts and follow the rows
+    expectFind(instance, table);
+
+    // radix sort
+    auto byKey = [&](int sign) {
+        return [&, sign] {
+            return [keyValues = keys(instance, table), sign](size_t left, size_t right) {
+                return sign * compareKeys(keyValues[left], keyValues[right]);
+            };
+        };
+    };
+    sortStable(instance, table, {table.key}, DDS_SORT_ASCENDING, byKey(1));
+    expectFind(instance, table);
+    sortStable(instance, table, {table.key}, DDS_SORT_DESCENDING, byKey(-1));
+    expectFind(instance, table);
+
+    // merge sort, string keys are not radix sorted
+    sortStable(instance, table, {table.name, table.key}, DDS_SORT_ASCENDING, [&] {
+        return [nameValues = names(instance, table), keyValues = keys(instance, table)](
+                size_t left, size_t right) {
+            int compared = nameValues[left].compare(nameValues[right]);
+            return compared != 0 ? compared : compareKeys(keyValues[left], keyValues[right]);
+        };
+    });
+    expectFind(instance, table);
+
+    ddsDeleteInstance(instance);
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
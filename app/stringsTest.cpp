@@ -0,0 +1,141 @@
+#include "test.hpp"
+
+// DDS_STRING_TYPE values are inserted, updated and read again after the instance is opened
+// anew, from a single file and from a segmented directory. A segmented instance mapped with
+// MMAP_WRITE keeps updates closed without a checkpoint, compacted heaps included.
+namespace {
+    using test::check;
+    using test::expect;
+
+    constexpr DdsInstanceCreateFlags segmented = DDS_INSTANCE_CREATE_SEGMENTED;
+    constexpr DdsInstanceCreateFlags lazy = static_cast<DdsInstanceCreateFlags>(
+            DDS_INSTANCE_CREATE_SEGMENTED | DDS_INSTANCE_CREATE_LAZY);
+    constexpr DdsInstanceCreateFlags mapped = static_cast<DdsInstanceCreateFlags>(
+            DDS_INSTANCE_CREATE_SEGMENTED | DDS_INSTANCE_CREATE_MMAP_WRITE);
+
+    std::vector<uint8_t> stringValues(std::vector<std::string> const &values) {
+        std::vector<DdsSize> offsets{0};
+        std::string chars;
+        for (auto const &value : values) {
+            chars += value;
+            offsets.push_back(chars.size());
+        }
+        std::vector<uint8_t> result(offsets.size() * sizeof(DdsSize) + chars.size());
+        std::memcpy(result.data(), offsets.data(), offsets.size() * sizeof(DdsSize));
+        std::memcpy(result.data() + offsets.size() * sizeof(DdsSize), chars.data(), chars.size());
+        return result;
+    }
+
+    // the table holds a number next to the name, so the heap lives beside another segment
+    DdsId nameColumn(DdsInstance instance) {
+        DdsId table, column;
+        check(ddsGetTable(instance, "names", &table), "ddsGetTable");
+        check(ddsGetColumn(instance, table, "name", &column), "ddsGetColumn");
+        return column;
+    }
+
+    void create(DdsInstance instance, std::vector<std::string> const &names) {
+        DdsId table;
+        test::createTable(instance, "names", {"id", "name"}, {DDS_UINT64_TYPE, DDS_STRING_TYPE},
+                &table);
+        std::vector<uint64_t> ids(names.size());
+        auto values = stringValues(names);
+        DdsDataType types[] = {DDS_UINT64_TYPE, DDS_STRING_TYPE};
+        DdsData data[] = {
+                {reinterpret_cast<uint8_t const *>(ids.data()), ids.size() * sizeof(uint64_t)},
+                {values.data(), values.size()},
+        };
+        check(ddsInsert(instance, table, names.size(), 2, types, data), "ddsInsert");
+    }
+
+    void update(DdsInstance instance, DdsId position, std::string const &name) {
+        auto value = stringValues({name});
+        check(ddsRecordUpdate(instance, nameColumn(instance), 0, position, DDS_STRING_TYPE,
+                value.data()), "ddsRecordUpdate");
+        check(ddsFlushCommands(instance), "ddsFlushCommands");
+    }
+
+    std::vector<std::string> names(DdsInstance instance) {
+        DdsId column = nameColumn(instance);
+        DdsColumnData cells;
+        check(ddsColumnData(instance, column, DDS_STRING_TYPE, &cells), "ddsColumnData");
+        DdsData heap;
+        check(ddsStringHeap(instance, column, &heap), "ddsStringHeap");
+
+        std::vector<std::string> result(cells.size / cells.stride);
+        for (size_t i = 0; i != result.size(); ++i) {
+            DdsStringRef cell;
+            std::memcpy(&cell, cells.pData + i * cells.stride, sizeof(cell));
+            expect(cell.offset + cell.length <= heap.size, "cells inside the heap");
+            result[i].assign(reinterpret_cast<char const *>(heap.pData) + cell.offset,
+                    cell.length);
+        }
+        return result;
+    }
+
+    std::vector<std::string> reopen(std::filesystem::path const &path,
+            DdsInstanceCreateFlags flags) {
+        DdsInstance instance;
+        check(ddsCreateInstance(flags, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+        auto result = names(instance);
+        ddsDeleteInstance(instance);
+        return result;
+    }
+
+    // inserts and updates, serialized and read back with each of the flags
+    void roundTrip(char const *name, DdsInstanceCreateFlags flags,
+            std::vector<DdsInstanceCreateFlags> const &readFlags) {
+        auto path = test::tempPath(name);
+        DdsInstance instance;
+        check(ddsCreateInstance(flags, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+        create(instance, {"a", "bb", "ccc"});
+        check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+        update(instance, 1, "updated");
+        check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+        ddsDeleteInstance(instance);
+
+        std::vector<std::string> expected{"a", "updated", "ccc"};
+        for (auto readFlag : readFlags) {
+            expect(reopen(path, readFlag) == expected, "the serialized names");
+        }
+        std::filesystem::remove_all(path);
+    }
+}
+
+int main() {
+    roundTrip("dds_strings_test_file", DdsInstanceCreateFlags{}, {DdsInstanceCreateFlags{}});
+    roundTrip("dds_strings_test_segmented", segmented, {segmented, lazy, mapped});
+
+    auto path = test::tempPath("dds_strings_test_mapped");
+    DdsInstance instance;
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    create(instance, {"a", "bb", "ccc"});
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    ddsDeleteInstance(instance);
+
+    // the heap grows past the size in the manifest
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    update(instance, 1, "updated");
+    ddsDeleteInstance(instance);
+    expect(reopen(path, mapped) == std::vector<std::string>{"a", "updated", "ccc"},
+            "the update written in place");
+
+    // enough garbage to compact the heap
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    for (size_t i = 0; i != 200; ++i) {
+        update(instance, 0, std::string(1000, static_cast<char>('a' + i % 26)));
+    }
+    update(instance, 2, "last");
+    ddsDeleteInstance(instance);
+    std::vector<std::string> expected{std::string(1000, 'a' + 199 % 26), "updated", "last"};
+    expect(reopen(path, mapped) == expected, "the compacted heap written in place");
+
+    // a checkpoint writes the checksums again, so a copy read into memory is checked
+    check(ddsCreateInstance(mapped, path.c_str(), nullptr, &instance), "ddsCreateInstance");
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    ddsDeleteInstance(instance);
+    expect(reopen(path, segmented) == expected, "the checkpointed names");
+
+    std::filesystem::remove_all(path);
+    return EXIT_SUCCESS;
+}
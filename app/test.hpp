@@ -0,0 +1,63 @@
+#pragma once
+
+#include "dds/dds.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Helpers of the test executables, which exit with EXIT_FAILURE on the first failed check
+namespace test {
+    inline void check(DdsResult result, char const *what) {
+        if (result != DDS_RESULT_SUCCESS) {
+            std::fprintf(stderr, "%s failed with %d\n", what, result);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    inline void expect(bool condition, char const *what) {
+        if (!condition) {
+            std::fprintf(stderr, "expected %s\n", what);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    inline std::filesystem::path tempPath(char const *name) {
+        auto path = std::filesystem::temp_directory_path() / name;
+        std::filesystem::remove_all(path);
+        return path;
+    }
+
+    // soa table, returns its columns
+    inline std::vector<DdsId> createTable(DdsInstance instance, char const *name,
+            std::vector<char const *> const &columnNames, std::vector<DdsDataType> const &types,
+            DdsId *pTable) {
+        check(ddsCreateTable(instance, DDS_TABLE_SOA, name, columnNames.size(),
+                columnNames.data(), types.data(), pTable), "ddsCreateTable");
+
+        DdsId const *pColumns;
+        DdsSize columnCount;
+        check(ddsGetTableColumns(instance, *pTable, &pColumns, &columnCount),
+                "ddsGetTableColumns");
+        return {pColumns, pColumns + columnCount};
+    }
+
+    inline void insert(DdsInstance instance, DdsId table, std::vector<uint64_t> const &values) {
+        DdsDataType type = DDS_UINT64_TYPE;
+        DdsData data{reinterpret_cast<uint8_t const *>(values.data()),
+                values.size() * sizeof(uint64_t)};
+        check(ddsInsert(instance, table, values.size(), 1, &type, &data), "ddsInsert");
+    }
+
+    inline std::vector<uint64_t> values(DdsInstance instance, DdsId column) {
+        DdsColumnData data;
+        check(ddsColumnData(instance, column, DDS_UINT64_TYPE, &data), "ddsColumnData");
+        std::vector<uint64_t> result(data.size / data.stride);
+        for (size_t i = 0; i != result.size(); ++i) {
+            std::memcpy(&result[i], data.pData + i * data.stride, sizeof(uint64_t));
+        }
+        return result;
+    }
+}
@@ -0,0 +1,96 @@
+#include "test.hpp"
+#include <numeric>
+
+// Changes logged with DDS_INSTANCE_CREATE_WAL are replayed after the instance is deleted without
+// a snapshot, like after a crash. A record torn by a crash is cut off, snapshots drop the records
+// they contain, an async one keeping those logged while it was written.
+namespace {
+    using test::check;
+    using test::expect;
+
+    std::filesystem::path logPath(std::filesystem::path const &path) {
+        return path.string() + ".wal";
+    }
+
+    DdsInstance open(std::filesystem::path const &path) {
+        DdsInstance instance;
+        check(ddsCreateInstance(DDS_INSTANCE_CREATE_WAL, path.c_str(), nullptr, &instance),
+                "ddsCreateInstance");
+        return instance;
+    }
+
+    DdsId valueTable(DdsInstance instance) {
+        DdsId table;
+        check(ddsGetTable(instance, "values", &table), "ddsGetTable");
+        return table;
+    }
+
+    std::vector<uint64_t> values(DdsInstance instance) {
+        DdsId column;
+        check(ddsGetColumn(instance, valueTable(instance), "value", &column), "ddsGetColumn");
+        return test::values(instance, column);
+    }
+
+    std::vector<uint64_t> reopened(std::filesystem::path const &path) {
+        DdsInstance instance = open(path);
+        auto result = values(instance);
+        ddsDeleteInstance(instance);
+        return result;
+    }
+}
+
+int main() {
+    auto path = test::tempPath("dds_wal_test");
+    std::filesystem::remove(logPath(path));
+
+    DdsInstance instance = open(path);
+    DdsId table;
+    DdsId column = test::createTable(instance, "values", {"value"}, {DDS_UINT64_TYPE}, &table)[0];
+    test::insert(instance, table, {1, 2, 3});
+    check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+    expect(std::filesystem::file_size(logPath(path)) == 0, "an empty log after a snapshot");
+
+    // inserts, then an update and a remove in one flush
+    test::insert(instance, table, {4, 5});
+    uint64_t value = 10;
+    check(ddsRecordUpdate(instance, column, 0, 0, DDS_UINT64_TYPE, &value), "ddsRecordUpdate");
+    check(ddsRecordRemove(instance, table, 1, 1), "ddsRecordRemove");
+    check(ddsFlushCommands(instance), "ddsFlushCommands");
+    auto expected = values(instance);
+    ddsDeleteInstance(instance);
+    expect(reopened(path) == expected, "the logged changes replayed");
+
+    // a crash in the middle of an append leaves part of the last record
+    auto intactSize = std::filesystem::file_size(logPath(path));
+    instance = open(path);
+    test::insert(instance, valueTable(instance), {6});
+    ddsDeleteInstance(instance);
+    std::filesystem::resize_file(logPath(path), intactSize + 7);
+    expect(reopened(path) == expected, "the torn record ignored");
+    expect(std::filesystem::file_size(logPath(path)) == intactSize, "the torn record cut off");
+
+    instance = open(path);
+    test::insert(instance, valueTable(instance), {7});
+    ddsDeleteInstance(instance);
+    expected.push_back(7);
+    expect(reopened(path) == expected, "records appended behind the cut");
+
+    // enough rows that the insert below is logged while the snapshot is written
+    instance = open(path);
+    std::vector<uint64_t> rows(1 << 21);
+    std::iota(rows.begin(), rows.end(), 100);
+    test::insert(instance, valueTable(instance), rows);
+    DdsSerializeJob job;
+    check(ddsSerializeAsync(instance, DdsSerializeFlags{}, &job), "ddsSerializeAsync");
+    test::insert(instance, valueTable(instance), {8});
+    check(ddsWaitSerialize(job), "ddsWaitSerialize");
+    ddsDeleteSerializeJob(job);
+    expected = values(instance);
+    ddsDeleteInstance(instance);
+    expect(std::filesystem::file_size(logPath(path)) < 1024, "the snapshot rows dropped");
+    expect(reopened(path) == expected, "the insert logged during the snapshot replayed");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(logPath(path));
+    return EXIT_SUCCESS;
+}
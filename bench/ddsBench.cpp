@@ -0,0 +1,346 @@
+#include "dds/dds.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Measures the core operations for every table layout and writes one JSON document:
+// {"results": [{"benchmark", "layout", "rows", "ops", "seconds", "nsPerOp"}, ...]}
+//
+// dds_bench [--min-rows N] [--max-rows N] [--ops N] [--output path]
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        size_t minRows = 1000;
+        size_t maxRows = 100000000;
+        size_t maxOps = 1000000; // cap of the operations timed by the per row benchmarks
+        char const *output = nullptr;
+    };
+
+    struct Result {
+        char const *benchmark;
+        char const *layout;
+        size_t rows;
+        size_t ops;
+        double seconds;
+    };
+
+    struct Layout {
+        DdsTableType type;
+        char const *name;
+    };
+
+    constexpr Layout layouts[] = {
+            {DDS_TABLE_SOA, "soa"},
+            {DDS_TABLE_AOS, "aos"},
+            {DDS_TABLE_AOS_PACK, "aos_pack"},
+            {DDS_TABLE_AOS_STD140, "aos_std140"},
+    };
+
+    // keeps the compiler from dropping scans and lookups
+    volatile uint64_t sink;
+
+    void check(DdsResult result, char const *what) {
+        if (result != DDS_RESULT_SUCCESS) {
+            std::fprintf(stderr, "dds_bench: %s failed with %d\n", what, result);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    template<typename FnT>
+    double measure(FnT &&f) {
+        auto begin = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    class Bench {
+    public:
+        Bench(Layout layout, size_t rows, size_t maxOps, std::vector<Result> &results) :
+                layout(layout), rows(rows), ops(std::min(rows, maxOps)), results(results) {
+            path = std::filesystem::temp_directory_path() /
+                    ("dds_bench_" + std::string(layout.name) + "_" + std::to_string(rows));
+            std::filesystem::remove(path);
+            check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+                    "ddsCreateInstance");
+        }
+
+        ~Bench() {
+            ddsDeleteInstance(instance);
+            std::filesystem::remove(path);
+        }
+
+        void run() {
+            insertBatch();
+            insertSingle();
+            scan();
+            find();
+            remove();
+            findChild();
+            findChildren();
+        }
+
+    private:
+        struct Table {
+            DdsId id;
+            std::vector<DdsId> columns;
+        };
+
+        Table createTable(char const *name, std::vector<char const *> const &columnNames,
+                std::vector<DdsDataType> const &types) {
+            Table table{};
+            check(ddsCreateTable(instance, layout.type, name, columnNames.size(),
+                    columnNames.data(), types.data(), &table.id), "ddsCreateTable");
+
+            DdsId const *pColumns;
+            DdsSize columnCount;
+            check(ddsGetTableColumns(instance, table.id, &pColumns, &columnCount),
+                    "ddsGetTableColumns");
+            table.columns.assign(pColumns, pColumns + columnCount);
+            return table;
+        }
+
+        Table createParentTable(char const *name) {
+            return createTable(name, {"id", "value", "position"},
+                    {DDS_UINT64_TYPE, DDS_FLOAT_TYPE, DDS_VEC3F_TYPE});
+        }
+
+        void insertParents(Table const &table, size_t begin, size_t count) {
+            std::vector<uint64_t> ids(count);
+            std::vector<float> values(count);
+            std::vector<DdsVec3F> positions(count);
+            for (size_t i = 0; i != count; ++i) {
+                ids[i] = begin + i;
+                values[i] = static_cast<float>(i % 1024);
+                positions[i] = {values[i], 1.0f, 2.0f};
+            }
+
+            DdsDataType types[] = {DDS_UINT64_TYPE, DDS_FLOAT_TYPE, DDS_VEC3F_TYPE};
+            DdsData data[] = {
+                    {reinterpret_cast<uint8_t const *>(ids.data()), count * sizeof(uint64_t)},
+                    {reinterpret_cast<uint8_t const *>(values.data()), count * sizeof(float)},
+                    {reinterpret_cast<uint8_t const *>(positions.data()),
+                            count * sizeof(DdsVec3F)},
+            };
+            check(ddsInsert(instance, table.id, count, 3, types, data), "ddsInsert");
+        }
+
+        void insertChildren(Table const &table, size_t parentCount) {
+            std::vector<uint64_t> parents(rows);
+            for (size_t i = 0; i != rows; ++i) {
+                parents[i] = i % parentCount;
+            }
+
+            DdsDataType type = DDS_UINT64_TYPE;
+            DdsData data{reinterpret_cast<uint8_t const *>(parents.data()),
+                    rows * sizeof(uint64_t)};
+            check(ddsInsert(instance, table.id, rows, 1, &type, &data), "ddsInsert");
+        }
+
+        void add(char const *benchmark, size_t count, double seconds) {
+            results.push_back({benchmark, layout.name, rows, count, seconds});
+        }
+
+        void insertBatch() {
+            parent = createParentTable("parent");
+            add("insert_batch", 1, measure([this] {
+                insertParents(parent, 0, rows);
+            }));
+        }
+
+        void insertSingle() {
+            Table table = createParentTable("single");
+            add("insert_single", ops, measure([this, &table] {
+                for (size_t i = 0; i != ops; ++i) {
+                    insertParents(table, i, 1);
+                }
+            }));
+            check(ddsDeleteTable(instance, table.id), "ddsDeleteTable");
+        }
+
+        void scan() {
+            DdsColumnData values, positions;
+            check(ddsColumnData(instance, parent.columns[1], DDS_FLOAT_TYPE, &values),
+                    "ddsColumnData");
+            check(ddsColumnData(instance, parent.columns[2], DDS_VEC3F_TYPE, &positions),
+                    "ddsColumnData");
+
+            add("scan_float", rows, measure([&values] {
+                float sum = 0;
+                size_t count = values.size / values.stride;
+                for (size_t i = 0; i != count; ++i) {
+                    float value;
+                    std::memcpy(&value, values.pData + i * values.stride, sizeof(value));
+                    sum += value;
+                }
+                sink = static_cast<uint64_t>(sum);
+            }));
+
+            add("scan_vec3f", rows, measure([&positions] {
+                float sum = 0;
+                size_t count = positions.size / positions.stride;
+                for (size_t i = 0; i != count; ++i) {
+                    DdsVec3F position;
+                    std::memcpy(&position, positions.pData + i * positions.stride,
+                            sizeof(position));
+                    sum += position.x + position.y + position.z;
+                }
+                sink = static_cast<uint64_t>(sum);
+            }));
+        }
+
+        void find() {
+            DdsId column = parent.columns[0];
+            uint64_t value = rows / 2;
+            DdsId position;
+
+            // the first lookup builds the index
+            add("find_cold", 1, measure([&] {
+                check(ddsFind(instance, column, DDS_UINT64_TYPE, &value, &position), "ddsFind");
+            }));
+
+            std::vector<uint64_t> keys = randomKeys(rows);
+            add("find_warm", ops, measure([&] {
+                uint64_t found = 0;
+                for (uint64_t key : keys) {
+                    check(ddsFind(instance, column, DDS_UINT64_TYPE, &key, &position), "ddsFind");
+                    found += position;
+                }
+                sink = found;
+            }));
+        }
+
+        // keeps the index up to date while removing, half the table at most
+        void remove() {
+            size_t count = std::min(ops, rows / 2);
+            std::mt19937_64 random(rows);
+            add("remove", count, measure([&] {
+                for (size_t i = 0; i != count; ++i) {
+                    check(ddsRemove(instance, parent.id, random() % (rows - i)), "ddsRemove");
+                }
+            }));
+            parentCount = rows - count;
+        }
+
+        void findChild() {
+            Table child = createTable("child", {"parent"}, {DDS_UINT64_TYPE});
+            insertChildren(child, parentCount);
+            check(ddsMakeConnection(instance, parent.id, child.columns[0],
+                    DDS_CONNECTION_SINGLE), "ddsMakeConnection");
+
+            std::vector<uint64_t> keys = randomKeys(parentCount);
+            add("find_child", ops, measure([&] {
+                uint64_t found = 0;
+                for (uint64_t key : keys) {
+                    DdsId position;
+                    if (ddsFindChild(instance, child.columns[0], key, &position) ==
+                            DDS_RESULT_SUCCESS) {
+                        found += position;
+                    }
+                }
+                sink = found;
+            }));
+        }
+
+        // four children per parent on average
+        void findChildren() {
+            Table children = createTable("children", {"parent"}, {DDS_UINT64_TYPE});
+            size_t childParents = std::max<size_t>(parentCount / 4, 1);
+            insertChildren(children, childParents);
+            check(ddsMakeConnection(instance, parent.id, children.columns[0],
+                    DDS_CONNECTION_MULTI), "ddsMakeConnection");
+
+            std::vector<uint64_t> keys = randomKeys(childParents);
+            add("find_children", ops, measure([&] {
+                uint64_t found = 0;
+                for (uint64_t key : keys) {
+                    DdsRowIndex const *pChildren;
+                    DdsSize count;
+                    ddsFindChildren(instance, children.columns[0], key, nullptr, &count);
+                    ddsFindChildren(instance, children.columns[0], key, &pChildren, &count);
+                    found += count;
+                }
+                sink = found;
+            }));
+        }
+
+        std::vector<uint64_t> randomKeys(size_t range) {
+            std::mt19937_64 random(range);
+            std::vector<uint64_t> keys(ops);
+            for (auto &key : keys) {
+                key = random() % range;
+            }
+            return keys;
+        }
+
+        Layout layout;
+        size_t rows;
+        size_t ops;
+        size_t parentCount = 0;
+        std::vector<Result> &results;
+        std::filesystem::path path;
+        DdsInstance instance = nullptr;
+        Table parent{};
+    };
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            if (std::strcmp(argv[i], "--min-rows") == 0) {
+                options.minRows = std::strtoull(argv[i + 1], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--max-rows") == 0) {
+                options.maxRows = std::strtoull(argv[i + 1], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--ops") == 0) {
+                options.maxOps = std::strtoull(argv[i + 1], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--output") == 0) {
+                options.output = argv[i + 1];
+            } else {
+                std::fprintf(stderr, "dds_bench: unknown option %s\n", argv[i]);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        options.minRows = std::max<size_t>(options.minRows, 1);
+        options.maxOps = std::max<size_t>(options.maxOps, 1);
+        return options;
+    }
+
+    void writeJson(std::FILE *file, std::vector<Result> const &results) {
+        std::fprintf(file, "{\n  \"results\": [");
+        for (size_t i = 0; i != results.size(); ++i) {
+            auto const &result = results[i];
+            std::fprintf(file, "%s\n    {\"benchmark\": \"%s\", \"layout\": \"%s\", \"rows\": %zu, "
+                    "\"ops\": %zu, \"seconds\": %.9f, \"nsPerOp\": %.3f}", i ? "," : "",
+                    result.benchmark, result.layout, result.rows, result.ops, result.seconds,
+                    result.seconds * 1e9 / static_cast<double>(std::max<size_t>(result.ops, 1)));
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options = parseOptions(argc, argv);
+
+    std::vector<Result> results;
+    for (size_t rows = options.minRows; rows <= options.maxRows; rows *= 10) {
+        for (auto const &layout : layouts) {
+            Bench(layout, rows, options.maxOps, results).run();
+        }
+    }
+
+    std::FILE *file = options.output ? std::fopen(options.output, "w") : stdout;
+    if (!file) {
+        std::fprintf(stderr, "dds_bench: can not open %s\n", options.output);
+        return EXIT_FAILURE;
+    }
+    writeJson(file, results);
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    return EXIT_SUCCESS;
+}
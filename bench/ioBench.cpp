@@ -0,0 +1,291 @@
+#include "dds/dds.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+// Measures persistence and startup on synthetic instances and writes one JSON document:
+// {"results": [{"benchmark", "mode", "cache", "rows", "tables", "bytes", "seconds",
+//               "mbPerSecond", "peakRssBytes"}, ...]}
+//
+// Cold runs drop the pages of the instance file with posix_fadvise(DONTNEED) first, which
+// only evicts clean pages, so the file is synced before.
+//
+// dds_io_bench [--min-rows N] [--max-rows N] [--output path]
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t tableCounts[] = {1, 16, 256};
+
+    struct Options {
+        size_t minRows = 10000;
+        size_t maxRows = 10000000;
+        char const *output = nullptr;
+    };
+
+    struct Result {
+        char const *benchmark;
+        char const *mode;
+        char const *cache;
+        size_t rows;
+        size_t tables;
+        size_t bytes;
+        double seconds;
+        size_t peakRss;
+    };
+
+    struct Mode {
+        DdsInstanceCreateFlags flags;
+        char const *name;
+    };
+
+    constexpr Mode modes[] = {
+            {DdsInstanceCreateFlags{}, "default"},
+            {DDS_INSTANCE_CREATE_MMAP_READ, "mmap_read"},
+            {DDS_INSTANCE_CREATE_MMAP_WRITE, "mmap_write"},
+    };
+
+    volatile double sink;
+
+    void check(DdsResult result, char const *what) {
+        if (result != DDS_RESULT_SUCCESS) {
+            std::fprintf(stderr, "dds_io_bench: %s failed with %d\n", what, result);
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    template<typename FnT>
+    double measure(FnT &&f) {
+        auto begin = Clock::now();
+        f();
+        return std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    // Resets the high water mark of the resident set, Linux only. Without it the peak is the
+    // one of the whole process.
+    void resetPeakRss() {
+        if (std::FILE *file = std::fopen("/proc/self/clear_refs", "w")) {
+            std::fputs("5", file);
+            std::fclose(file);
+        }
+    }
+
+    size_t peakRss() {
+        if (std::FILE *file = std::fopen("/proc/self/status", "r")) {
+            char line[256];
+            size_t kiloBytes = 0;
+            while (std::fgets(line, sizeof(line), file)) {
+                if (std::sscanf(line, "VmHWM: %zu kB", &kiloBytes) == 1) {
+                    break;
+                }
+            }
+            std::fclose(file);
+            if (kiloBytes) {
+                return kiloBytes * 1024;
+            }
+        }
+
+        rusage usage{};
+        ::getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;
+    }
+
+    void dropPages(std::filesystem::path const &path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+
+    class Bench {
+    public:
+        Bench(size_t rows, size_t tables, std::vector<Result> &results) :
+                rows(rows), tables(tables), results(results) {
+            path = std::filesystem::temp_directory_path() /
+                    ("dds_io_bench_" + std::to_string(rows) + "_" + std::to_string(tables));
+        }
+
+        ~Bench() {
+            std::filesystem::remove(path);
+        }
+
+        void run() {
+            serialize();
+            for (auto const &mode : modes) {
+                open(mode, "cold");
+                open(mode, "warm");
+            }
+        }
+
+    private:
+        void add(char const *benchmark, char const *mode, char const *cache, double seconds) {
+            results.push_back({benchmark, mode, cache, rows, tables, bytes, seconds, peakRss()});
+        }
+
+        // rows spread evenly over the tables, all soa with a key, a scalar and a vector column
+        void fill(DdsInstance instance) {
+            char const *names[] = {"id", "value", "position"};
+            DdsDataType types[] = {DDS_UINT64_TYPE, DDS_DOUBLE_TYPE, DDS_VEC3F_TYPE};
+
+            size_t tableRows = std::max<size_t>(rows / tables, 1);
+            std::vector<uint64_t> ids(tableRows);
+            std::vector<double> values(tableRows);
+            std::vector<DdsVec3F> positions(tableRows);
+            for (size_t i = 0; i != tableRows; ++i) {
+                ids[i] = i;
+                values[i] = static_cast<double>(i);
+                positions[i] = {1.0f, 2.0f, 3.0f};
+            }
+            DdsData data[] = {
+                    {reinterpret_cast<uint8_t const *>(ids.data()), tableRows * sizeof(uint64_t)},
+                    {reinterpret_cast<uint8_t const *>(values.data()), tableRows * sizeof(double)},
+                    {reinterpret_cast<uint8_t const *>(positions.data()),
+                            tableRows * sizeof(DdsVec3F)},
+            };
+
+            for (size_t table = 0; table != tables; ++table) {
+                std::string name = "table" + std::to_string(table);
+                DdsId id;
+                check(ddsCreateTable(instance, DDS_TABLE_SOA, name.c_str(), 3, names, types, &id),
+                        "ddsCreateTable");
+                check(ddsInsert(instance, id, tableRows, 3, types, data), "ddsInsert");
+            }
+        }
+
+        void serialize() {
+            std::filesystem::remove(path);
+
+            resetPeakRss();
+            DdsInstance instance;
+            check(ddsCreateInstance(DdsInstanceCreateFlags{}, path.c_str(), nullptr, &instance),
+                    "ddsCreateInstance");
+            fill(instance);
+
+            double seconds = measure([instance] {
+                check(ddsSerialize(instance, DdsSerializeFlags{}), "ddsSerialize");
+            });
+            ddsDeleteInstance(instance);
+
+            bytes = std::filesystem::file_size(path);
+            add("serialize", "default", "warm", seconds);
+        }
+
+        // Opening alone may touch nothing with mmap, so the first query reads a whole column of
+        // the last table to make the modes comparable.
+        // MMAP_WRITE fixes the pointers up in the file itself, so it opens a copy of it.
+        void open(Mode const &mode, char const *cache) {
+            std::filesystem::path openPath = path;
+            if (mode.flags & DDS_INSTANCE_CREATE_MMAP_WRITE) {
+                openPath += ".write";
+                std::filesystem::copy_file(path, openPath,
+                        std::filesystem::copy_options::overwrite_existing);
+            }
+            if (std::strcmp(cache, "cold") == 0) {
+                dropPages(openPath);
+            }
+
+            resetPeakRss();
+            DdsInstance instance;
+            double openSeconds = measure([&] {
+                check(ddsCreateInstance(mode.flags, openPath.c_str(), nullptr, &instance),
+                        "ddsCreateInstance");
+            });
+
+            double querySeconds = measure([instance, this] {
+                std::string name = "table" + std::to_string(tables - 1);
+                DdsId table, column;
+                check(ddsGetTable(instance, name.c_str(), &table), "ddsGetTable");
+                check(ddsGetColumn(instance, table, "value", &column), "ddsGetColumn");
+
+                DdsColumnData values;
+                check(ddsColumnData(instance, column, DDS_DOUBLE_TYPE, &values), "ddsColumnData");
+                double sum = 0;
+                for (size_t i = 0; i != values.size / values.stride; ++i) {
+                    double value;
+                    std::memcpy(&value, values.pData + i * values.stride, sizeof(value));
+                    sum += value;
+                }
+                sink = sum;
+            });
+
+            add("create", mode.name, cache, openSeconds);
+            add("first_query", mode.name, cache, querySeconds);
+            add("create_and_first_query", mode.name, cache, openSeconds + querySeconds);
+            ddsDeleteInstance(instance);
+            if (openPath != path) {
+                std::filesystem::remove(openPath);
+            }
+        }
+
+        size_t rows;
+        size_t tables;
+        size_t bytes = 0;
+        std::vector<Result> &results;
+        std::filesystem::path path;
+    };
+
+    Options parseOptions(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            if (std::strcmp(argv[i], "--min-rows") == 0) {
+                options.minRows = std::strtoull(argv[i + 1], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--max-rows") == 0) {
+                options.maxRows = std::strtoull(argv[i + 1], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--output") == 0) {
+                options.output = argv[i + 1];
+            } else {
+                std::fprintf(stderr, "dds_io_bench: unknown option %s\n", argv[i]);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        options.minRows = std::max<size_t>(options.minRows, 1);
+        return options;
+    }
+
+    void writeJson(std::FILE *file, std::vector<Result> const &results) {
+        std::fprintf(file, "{\n  \"results\": [");
+        for (size_t i = 0; i != results.size(); ++i) {
+            auto const &result = results[i];
+            double megaBytes = static_cast<double>(result.bytes) / (1024 * 1024);
+            std::fprintf(file, "%s\n    {\"benchmark\": \"%s\", \"mode\": \"%s\", \"cache\": \"%s\", "
+                    "\"rows\": %zu, \"tables\": %zu, \"bytes\": %zu, \"seconds\": %.9f, "
+                    "\"mbPerSecond\": %.3f, \"peakRssBytes\": %zu}", i ? "," : "",
+                    result.benchmark, result.mode, result.cache, result.rows, result.tables,
+                    result.bytes, result.seconds, megaBytes / std::max(result.seconds, 1e-9),
+                    result.peakRss);
+        }
+        std::fprintf(file, "\n  ]\n}\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options = parseOptions(argc, argv);
+
+    std::vector<Result> results;
+    for (size_t rows = options.minRows; rows <= options.maxRows; rows *= 10) {
+        for (size_t tables : tableCounts) {
+            Bench(rows, tables, results).run();
+        }
+    }
+
+    std::FILE *file = options.output ? std::fopen(options.output, "w") : stdout;
+    if (!file) {
+        std::fprintf(stderr, "dds_io_bench: can not open %s\n", options.output);
+        return EXIT_FAILURE;
+    }
+    writeJson(file, results);
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    return EXIT_SUCCESS;
+}
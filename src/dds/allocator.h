@@ -7,10 +7,14 @@
 extern "C" {
 #endif
 
-typedef uint8_t *(*DdsAllocate)(DdsSize size);
+// alignment is a power of two, returns null when out of memory
+typedef void *(*DdsAllocate)(void *pUserData, DdsSize size, DdsSize alignment);
 
-typedef void *(*DdsDeallocate)(uint8_t *position);
+// receives the size and alignment the memory was allocated with
+typedef void (*DdsDeallocate)(void *pUserData, void *pMemory, DdsSize size, DdsSize alignment);
 
+// Backs column buffers, table arenas and index nodes of an instance. Memory is requested in
+// large blocks, so the callbacks are not on the hot path.
 typedef struct DdsAllocator {
     DdsAllocate allocate;
     DdsDeallocate deallocate;
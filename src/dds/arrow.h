@@ -0,0 +1,57 @@
+#pragma once
+
+#include "dds.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arrow C data interface, https://arrow.apache.org/docs/format/CDataInterface.html
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif
+
+// Exports a table as a struct array with one child per column. The array owns copies of the
+// columns, so it stays valid when the table changes, and strings are converted to utf8. The
+// caller releases schema and array.
+DdsResult ddsExportArrow(DdsInstance instance, DdsId table, struct ArrowSchema *pSchema,
+        struct ArrowArray *pArray);
+
+// Appends the rows of a struct array, children are matched to columns by name. Columns
+// missing in the array are zeroed, null values too. Takes ownership of schema and array.
+DdsResult ddsImportArrow(DdsInstance instance, DdsId table, struct ArrowSchema *pSchema,
+        struct ArrowArray *pArray);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "TableView.hpp"
+#include "../helpers/parallel.hpp"
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dds {
+    // Column pointers of one forEach call, resolved before the loop
+    template<size_t N>
+    struct ColumnSet {
+        std::array<uint8_t *, N> pData{};
+        DdsSize stride = 0;
+        DdsSize rows = 0;
+        bool isAos = false;
+    };
+
+    // Checks the columns against Ts and loads their pointers. Without names Ts are the columns
+    // of the table in order, otherwise the columns of the given names.
+    template<typename... Ts>
+    DdsResult resolveColumns(DdsInstance instance, DdsId table, char const *const *pNames,
+            ColumnSet<sizeof...(Ts)> &set) {
+        constexpr size_t count = sizeof...(Ts);
+        constexpr std::array<DdsDataType, count> types{
+                DataTypeOf<std::remove_const_t<Ts>>::value...};
+        constexpr std::array<size_t, count> alignments{alignof(Ts)...};
+
+        std::array<DdsId, count> columns{};
+        if (pNames) {
+            for (size_t i = 0; i != count; ++i) {
+                DdsResult result = ddsGetColumn(instance, table, pNames[i], &columns[i]);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+            }
+        } else {
+            DdsId const *pColumns;
+            DdsSize columnCount;
+            DdsResult result = ddsGetTableColumns(instance, table, &pColumns, &columnCount);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (columnCount != count) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+            std::copy(pColumns, pColumns + count, columns.begin());
+        }
+
+        // ddsColumnData checks the type
+        for (size_t i = 0; i != count; ++i) {
+            DdsColumnData column;
+            DdsResult result = ddsColumnData(instance, columns[i], types[i], &column);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (reinterpret_cast<uintptr_t>(column.pData) % alignments[i] != 0 ||
+                    column.stride % alignments[i] != 0) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+            set.pData[i] = column.pData;
+            set.stride = column.stride;
+            set.rows = column.stride ? column.size / column.stride : 0;
+        }
+
+        DdsData rowData;
+        set.isAos = ddsAosData(instance, columns[0], &rowData) == DDS_RESULT_SUCCESS;
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // Calls f for rows [begin, end). Soa columns are indexed as typed arrays so the loop can be
+    // vectorized, aos rows are stepped by the row size.
+    template<typename Layout, typename... Ts, typename FnT, size_t... Is>
+    void forEachRows(ColumnSet<sizeof...(Ts)> const &set, size_t begin, size_t end, FnT &f,
+            std::index_sequence<Is...>) {
+        if constexpr (std::is_same_v<Layout, SoaLayout>) {
+            std::tuple<Ts *...> columns{reinterpret_cast<Ts *>(set.pData[Is])...};
+            for (size_t i = begin; i != end; ++i) {
+                f(std::get<Is>(columns)[i]...);
+            }
+        } else {
+            size_t stride = set.stride;
+            for (size_t i = begin; i != end; ++i) {
+                f(*reinterpret_cast<Ts *>(set.pData[Is] + i * stride)...);
+            }
+        }
+    }
+
+    template<typename... Ts, typename FnT>
+    void forEachRows(ColumnSet<sizeof...(Ts)> const &set, size_t begin, size_t end, FnT &f) {
+        auto indices = std::index_sequence_for<Ts...>{};
+        if (set.isAos) {
+            forEachRows<AosLayout, Ts...>(set, begin, end, f, indices);
+        } else {
+            forEachRows<SoaLayout, Ts...>(set, begin, end, f, indices);
+        }
+    }
+
+    // Calls f(Ts &...) for every row, for example
+    //     forEach<DdsVec3F, DdsVec3F const>(instance, table, names,
+    //             [](DdsVec3F &position, DdsVec3F const &velocity) { ... });
+    // The table must not change while f runs.
+    template<typename... Ts, typename FnT>
+    DdsResult forEach(DdsInstance instance, DdsId table, char const *const *pNames, FnT &&f) {
+        ColumnSet<sizeof...(Ts)> set;
+        DdsResult result = resolveColumns<Ts...>(instance, table, pNames, set);
+        if (result == DDS_RESULT_SUCCESS) {
+            forEachRows<Ts...>(set, 0, set.rows, f);
+        }
+        return result;
+    }
+
+    template<typename... Ts, typename FnT>
+    DdsResult forEach(DdsInstance instance, DdsId table, FnT &&f) {
+        return forEach<Ts...>(instance, table, nullptr, std::forward<FnT>(f));
+    }
+
+    constexpr size_t forEachChunkRows = 16 * 1024;
+
+    // Like forEach, with chunks of rows spread over the hardware threads. f is called
+    // concurrently and must only touch the row it is given.
+    template<typename... Ts, typename FnT>
+    DdsResult parallelForEach(DdsInstance instance, DdsId table, char const *const *pNames,
+            FnT &&f) {
+        ColumnSet<sizeof...(Ts)> set;
+        DdsResult result = resolveColumns<Ts...>(instance, table, pNames, set);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        size_t chunks = (set.rows + forEachChunkRows - 1) / forEachChunkRows;
+        parallelFor(chunks, [&set, &f](size_t chunk) {
+            size_t begin = chunk * forEachChunkRows;
+            forEachRows<Ts...>(set, begin, std::min<size_t>(begin + forEachChunkRows, set.rows),
+                    f);
+        });
+        return DDS_RESULT_SUCCESS;
+    }
+
+    template<typename... Ts, typename FnT>
+    DdsResult parallelForEach(DdsInstance instance, DdsId table, FnT &&f) {
+        return parallelForEach<Ts...>(instance, table, nullptr, std::forward<FnT>(f));
+    }
+}
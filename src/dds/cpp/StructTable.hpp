@@ -0,0 +1,172 @@
+#pragma once
+
+#include "TableView.hpp"
+#include <array>
+#include <cista/reflection/to_tuple.h>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace dds {
+    template<typename T, typename = void>
+    struct HasColumnNames : std::false_type {};
+
+    template<typename T>
+    struct HasColumnNames<T, std::void_t<decltype(T::columnNames)>> : std::true_type {};
+
+    template<typename T>
+    constexpr size_t memberCount() {
+        return cista::arity<T>();
+    }
+
+    template<typename T, size_t I>
+    using MemberType = std::remove_reference_t<
+            std::tuple_element_t<I, decltype(cista::to_tuple(std::declval<T &>()))>>;
+
+    template<typename T, size_t... Is>
+    constexpr std::array<DdsDataType, sizeof...(Is)> memberTypes(std::index_sequence<Is...>) {
+        return {DataTypeOf<MemberType<T, Is>>::value...};
+    }
+
+    // byte offsets of the members as laid out by the compiler
+    template<typename T>
+    std::array<DdsSize, memberCount<T>()> memberOffsets() {
+        std::array<DdsSize, memberCount<T>()> result{};
+        T probe{};
+        auto base = reinterpret_cast<uint8_t const *>(&probe);
+        std::apply([&result, base](auto &... members) {
+            size_t i = 0;
+            ((result[i++] = static_cast<DdsSize>(
+                    reinterpret_cast<uint8_t const *>(&members) - base)), ...);
+        }, cista::to_tuple(probe));
+        return result;
+    }
+
+    // Rows of an aos table registered from a struct, accessed as T without copies
+    template<typename T>
+    class StructTable {
+    public:
+        DdsId id() const {
+            return table;
+        }
+
+        // valid until the table changes
+        DdsResult rows(Span<T> *pReturn) const {
+            DdsColumnData column;
+            DdsResult result = ddsColumnData(instance, firstColumn, firstType, &column);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (reinterpret_cast<uintptr_t>(column.pData) % alignof(T) != 0) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+
+            *pReturn = {reinterpret_cast<T *>(column.pData), column.size / sizeof(T)};
+            return DDS_RESULT_SUCCESS;
+        }
+
+        DdsResult insert(T const *pRows, DdsSize count) {
+            return ddsInsertRows(instance, table, count,
+                    {reinterpret_cast<uint8_t const *>(pRows), count * sizeof(T)});
+        }
+
+        DdsResult insert(Span<T const> rows) {
+            return insert(rows.data(), rows.size());
+        }
+
+        DdsResult remove(DdsId position) {
+            return ddsRemove(instance, table, position);
+        }
+
+    private:
+        template<typename U>
+        friend DdsResult registerTable(DdsInstance instance, char const *name,
+                StructTable<U> *pReturn);
+
+        DdsInstance instance = nullptr;
+        DdsId table = 0;
+        DdsId firstColumn = 0;
+        DdsDataType firstType = DDS_UINT64_TYPE;
+    };
+
+    // Creates a DDS_TABLE_AOS table with a column per member of T, or binds to the existing
+    // table of that name. Member types come from reflection, column names from a static
+    // columnNames array of T when it has one and are "0", "1", ... otherwise. The rows of the
+    // table have to match the compiler's layout of T byte for byte.
+    template<typename T>
+    DdsResult registerTable(DdsInstance instance, char const *name, StructTable<T> *pReturn) {
+        static_assert(std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>,
+                "rows are copied and accessed as raw memory");
+
+        constexpr size_t count = memberCount<T>();
+        static_assert(count != 0, "a table has at least one column");
+        constexpr auto types = memberTypes<T>(std::make_index_sequence<count>{});
+
+        DdsId table;
+        if (ddsGetTable(instance, name, &table) != DDS_RESULT_SUCCESS) {
+            std::array<std::string, count> numbers;
+            std::array<char const *, count> names{};
+            for (size_t i = 0; i != count; ++i) {
+                if constexpr (HasColumnNames<T>::value) {
+                    names[i] = T::columnNames[i];
+                } else {
+                    numbers[i] = std::to_string(i);
+                    names[i] = numbers[i].c_str();
+                }
+            }
+
+            DdsResult result = ddsCreateTable(instance, DDS_TABLE_AOS, name, count, names.data(),
+                    types.data(), &table);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        DdsId const *pColumns;
+        DdsSize columnCount;
+        DdsResult result = ddsGetTableColumns(instance, table, &pColumns, &columnCount);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+        if (columnCount != count) {
+            return DDS_RESULT_INVALID_TYPE;
+        }
+
+        auto offsets = memberOffsets<T>();
+        for (size_t i = 0; i != count; ++i) {
+            DdsDataType type;
+            result = ddsGetColumnType(instance, pColumns[i], &type);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (type != types[i]) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+
+            DdsSize offset;
+            result = ddsGetColumnOffset(instance, pColumns[i], &offset);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (offset != offsets[i]) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+        }
+
+        // the stride of an aos column is the row size
+        DdsColumnData column;
+        result = ddsColumnData(instance, pColumns[0], types[0], &column);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+        if (column.stride != sizeof(T)) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        pReturn->instance = instance;
+        pReturn->table = table;
+        pReturn->firstColumn = pColumns[0];
+        pReturn->firstType = types[0];
+        return DDS_RESULT_SUCCESS;
+    }
+}
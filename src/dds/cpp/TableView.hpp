@@ -0,0 +1,278 @@
+#pragma once
+
+#include "../dds.h"
+#include "../helpers/StrideIterator.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace dds {
+    template<typename T>
+    struct DataTypeOf;
+
+    template<>
+    struct DataTypeOf<DdsString16> : std::integral_constant<DdsDataType, DDS_STRING16_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsString64> : std::integral_constant<DdsDataType, DDS_STRING64_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsString256> : std::integral_constant<DdsDataType, DDS_STRING256_TYPE> {};
+
+    // Cells of a DDS_STRING_TYPE column can be read, values are passed to inserts and finds in
+    // the offsets layout instead
+    template<>
+    struct DataTypeOf<DdsStringRef> : std::integral_constant<DdsDataType, DDS_STRING_TYPE> {};
+
+    template<>
+    struct DataTypeOf<float> : std::integral_constant<DdsDataType, DDS_FLOAT_TYPE> {};
+
+    template<>
+    struct DataTypeOf<double> : std::integral_constant<DdsDataType, DDS_DOUBLE_TYPE> {};
+
+    template<>
+    struct DataTypeOf<int32_t> : std::integral_constant<DdsDataType, DDS_INT32_TYPE> {};
+
+    template<>
+    struct DataTypeOf<uint32_t> : std::integral_constant<DdsDataType, DDS_UINT32_TYPE> {};
+
+    template<>
+    struct DataTypeOf<int64_t> : std::integral_constant<DdsDataType, DDS_INT64_TYPE> {};
+
+    template<>
+    struct DataTypeOf<uint64_t> : std::integral_constant<DdsDataType, DDS_UINT64_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsVec2F> : std::integral_constant<DdsDataType, DDS_VEC2F_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsVec3F> : std::integral_constant<DdsDataType, DDS_VEC3F_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsVec4F> : std::integral_constant<DdsDataType, DDS_VEC4F_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsMat3F> : std::integral_constant<DdsDataType, DDS_MAT3F_TYPE> {};
+
+    template<>
+    struct DataTypeOf<DdsMat4F> : std::integral_constant<DdsDataType, DDS_MAT4F_TYPE> {};
+
+    template<typename T>
+    class Span {
+    public:
+        Span() = default;
+
+        Span(T *pData, size_t count) : pData(pData), count(count) {}
+
+        T *begin() const {
+            return pData;
+        }
+
+        T *end() const {
+            return pData + count;
+        }
+
+        T *data() const {
+            return pData;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        T &operator[](size_t i) const {
+            return pData[i];
+        }
+
+    private:
+        T *pData = nullptr;
+        size_t count = 0;
+    };
+
+    template<typename T>
+    class StrideRange {
+    public:
+        StrideRange() = default;
+
+        StrideRange(uint8_t *pData, size_t count, size_t stride) :
+                pData(pData), count(count), stride(stride) {}
+
+        StrideIterator<T> begin() const {
+            return {pData, stride};
+        }
+
+        StrideIterator<T> end() const {
+            return {pData + count * stride, stride};
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        T &operator[](size_t i) const {
+            return *reinterpret_cast<T *>(pData + i * stride);
+        }
+
+    private:
+        uint8_t *pData = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+    };
+
+    // Columns of DDS_TABLE_SOA tables are contiguous arrays
+    struct SoaLayout {
+        template<typename T>
+        using Range = Span<T>;
+    };
+
+    // Columns of DDS_TABLE_AOS, DDS_TABLE_AOS_PACK and DDS_TABLE_AOS_STD140 tables are strided
+    struct AosLayout {
+        template<typename T>
+        using Range = StrideRange<T>;
+    };
+
+    // Typed access to a table whose columns are Ts in column order. bind checks the column
+    // count, the column types, the layout and the alignment once, every access after that is
+    // plain pointer arithmetic without type dispatch.
+    //
+    // Ranges stay valid until the table changes. insert and remove refresh the view, changes
+    // made through the C API or another view need a refresh() before the next access.
+    template<typename Layout, typename... Ts>
+    class TableView {
+    public:
+        static_assert(sizeof...(Ts) != 0, "a table has at least one column");
+
+        static constexpr size_t columnCount = sizeof...(Ts);
+
+        template<size_t I>
+        using ColumnType = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+        template<size_t I>
+        using ColumnRange = typename Layout::template Range<ColumnType<I>>;
+
+        DdsResult bind(DdsInstance instance, DdsId table) {
+            DdsId const *pColumns;
+            DdsSize count;
+            DdsResult result = ddsGetTableColumns(instance, table, &pColumns, &count);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (count != columnCount) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+
+            for (size_t i = 0; i != columnCount; ++i) {
+                DdsDataType type;
+                result = ddsGetColumnType(instance, pColumns[i], &type);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+                if (type != types[i]) {
+                    return DDS_RESULT_INVALID_TYPE;
+                }
+            }
+
+            // only aos tables have row data
+            DdsData rowData;
+            bool isAos = ddsAosData(instance, pColumns[0], &rowData) == DDS_RESULT_SUCCESS;
+            if (isAos != std::is_same_v<Layout, AosLayout>) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+
+            this->instance = instance;
+            this->table = table;
+            std::copy(pColumns, pColumns + columnCount, columns.begin());
+            return refresh();
+        }
+
+        // Reloads the column pointers, packed aos columns that are not aligned for their type
+        // are refused
+        DdsResult refresh() {
+            for (size_t i = 0; i != columnCount; ++i) {
+                DdsColumnData column;
+                DdsResult result = ddsColumnData(instance, columns[i], types[i], &column);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+                if (reinterpret_cast<uintptr_t>(column.pData) % alignments[i] != 0 ||
+                        column.stride % alignments[i] != 0) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+                pData[i] = column.pData;
+                stride = column.stride;
+                rows = column.stride ? column.size / column.stride : 0;
+            }
+            return DDS_RESULT_SUCCESS;
+        }
+
+        DdsSize size() const {
+            return rows;
+        }
+
+        DdsId id() const {
+            return table;
+        }
+
+        template<size_t I>
+        DdsId column() const {
+            return columns[I];
+        }
+
+        template<size_t I>
+        ColumnRange<I> get() const {
+            using T = ColumnType<I>;
+            if constexpr (std::is_same_v<Layout, SoaLayout>) {
+                return {reinterpret_cast<T *>(pData[I]), rows};
+            } else {
+                return {pData[I], rows, stride};
+            }
+        }
+
+        // Appends count rows, pValues point to count values of each column
+        DdsResult insert(DdsSize count, Ts const *... pValues) {
+            static_assert((!std::is_same_v<Ts, DdsStringRef> && ...),
+                    "DDS_STRING_TYPE values are inserted through ddsInsert");
+            DdsData data[] = {{reinterpret_cast<uint8_t const *>(pValues), count * sizeof(Ts)}...};
+            DdsResult result = ddsInsert(instance, table, count, columnCount, types.data(), data);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            return refresh();
+        }
+
+        DdsResult insertRow(Ts const &... values) {
+            return insert(1, &values...);
+        }
+
+        DdsResult remove(DdsId position) {
+            DdsResult result = ddsRemove(instance, table, position);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            return refresh();
+        }
+
+        template<size_t I>
+        DdsResult find(ColumnType<I> const &value, DdsId *pResult) const {
+            static_assert(!std::is_same_v<ColumnType<I>, DdsStringRef>,
+                    "DDS_STRING_TYPE values are found through ddsFind");
+            return ddsFind(instance, columns[I], types[I], &value, pResult);
+        }
+
+    private:
+        static constexpr std::array<DdsDataType, columnCount> types{DataTypeOf<Ts>::value...};
+        static constexpr std::array<size_t, columnCount> alignments{alignof(Ts)...};
+
+        DdsInstance instance = nullptr;
+        DdsId table = 0;
+        std::array<DdsId, columnCount> columns{};
+        std::array<uint8_t *, columnCount> pData{};
+        DdsSize stride = 0;
+        DdsSize rows = 0;
+    };
+}
@@ -1,20 +1,138 @@
 #include "allocator.hpp"
 
 namespace dds {
-    AllocatorData makeAllocatorData(InstanceData &data, DdsAllocator allocator) {
-        using DataVec = std::vector<uint8_t, DataAllocator<uint8_t>>;
-        DataAllocator<uint8_t> stlAlloc(allocator);
-        AllocatorData allocatorData = { allocator, {}, {} };
+    void *allocateMemory(DdsAllocator const &allocator, size_t size, size_t alignment) {
+        if (allocator.allocate) {
+            return allocator.allocate(allocator.pUserData, size, alignment);
+        }
+        return ::operator new(size, std::align_val_t(alignment), std::nothrow);
+    }
+
+    void deallocateMemory(DdsAllocator const &allocator, void *p, size_t size, size_t alignment) {
+        if (allocator.deallocate) {
+            allocator.deallocate(allocator.pUserData, p, size, alignment);
+        } else {
+            ::operator delete(p, std::align_val_t(alignment));
+        }
+    }
+
+    Arena::Arena(DdsAllocator allocator, size_t blockSize) : allocator(allocator),
+            blockSize(blockSize) {}
+
+    Arena::~Arena() {
+        release();
+    }
+
+    void *Arena::allocate(size_t size, size_t alignment) {
+        uintptr_t p = (current + alignment - 1) / alignment * alignment;
+        if (current != 0 && p + size <= end) {
+            current = p + size;
+            used += size;
+            return reinterpret_cast<void *>(p);
+        }
+
+        // large allocations get a block of their own and leave the current one to small ones
+        bool dedicated = size > blockSize / 4;
+        size_t blockBytes = dedicated ? size : blockSize;
+        size_t blockAlignment = std::max(alignment, bufferAlignment);
+        void *pBlock = allocateMemory(allocator, blockBytes, blockAlignment);
+        if (!pBlock) {
+            return nullptr;
+        }
+        blocks.push_back({pBlock, blockBytes, blockAlignment, dedicated});
+        reserved += blockBytes;
+        used += size;
+
+        if (!dedicated) {
+            current = reinterpret_cast<uintptr_t>(pBlock) + size;
+            end = reinterpret_cast<uintptr_t>(pBlock) + blockBytes;
+        }
+        return pBlock;
+    }
+
+    void Arena::deallocate(void *p) {
+        for (size_t i = 0; i != blocks.size(); ++i) {
+            Block block = blocks[i];
+            if (block.pData == p && block.dedicated) {
+                deallocateMemory(allocator, block.pData, block.size, block.alignment);
+                blocks[i] = blocks.back();
+                blocks.pop_back();
+                reserved -= block.size;
+                used -= block.size;
+                return;
+            }
+        }
+    }
+
+    void Arena::release() {
+        for (auto const &block : blocks) {
+            deallocateMemory(allocator, block.pData, block.size, block.alignment);
+        }
+        blocks.clear();
+        current = 0;
+        end = 0;
+        reserved = 0;
+        used = 0;
+    }
+
+    SizeClassPool::SizeClassPool(DdsAllocator allocator) : allocator(allocator),
+            slabs(allocator, 256 * 1024) {}
+
+    size_t SizeClassPool::sizeClass(size_t size) {
+        size_t result = 0;
+        for (size_t classSize = minSize; classSize < size; classSize *= 2) {
+            ++result;
+        }
+        return result;
+    }
+
+    void *SizeClassPool::allocate(size_t size) {
+        if (size > maxSize) {
+            void *p = allocateMemory(allocator, size, alignof(std::max_align_t));
+            if (p) {
+                large += size;
+            }
+            return p;
+        }
 
-        for (auto const &tableData : data.aosTables.data) {
-            DataVec vec(tableData.begin(), tableData.end(), stlAlloc);
-            allocatorData.aosData.push_back(std::move(vec));
+        size_t index = sizeClass(size);
+        size_t classSize = minSize << index;
+        if (!freeLists[index]) {
+            // a slab of nodes aligned to their size, up to a cache line
+            constexpr size_t slabNodes = 64;
+            auto pSlab = static_cast<uint8_t *>(slabs.allocate(classSize * slabNodes,
+                    std::min(classSize, bufferAlignment)));
+            if (!pSlab) {
+                return nullptr;
+            }
+            for (size_t i = slabNodes; i != 0; --i) {
+                auto pNode = reinterpret_cast<FreeNode *>(pSlab + (i - 1) * classSize);
+                pNode->pNext = freeLists[index];
+                freeLists[index] = pNode;
+            }
         }
-        for (auto const &columnData : data.columns.soaColumnData) {
-            DataVec vec(columnData.begin(), columnData.end(), stlAlloc);
-            allocatorData.aosData.push_back(std::move(vec));
+
+        FreeNode *pNode = freeLists[index];
+        freeLists[index] = pNode->pNext;
+        used += classSize;
+        return pNode;
+    }
+
+    void SizeClassPool::deallocate(void *p, size_t size) {
+        if (size > maxSize) {
+            deallocateMemory(allocator, p, size, alignof(std::max_align_t));
+            large -= size;
+            return;
         }
 
-        return allocatorData;
+        size_t index = sizeClass(size);
+        auto pNode = static_cast<FreeNode *>(p);
+        pNode->pNext = freeLists[index];
+        freeLists[index] = pNode;
+        used -= minSize << index;
+    }
+
+    size_t SizeClassPool::reservedBytes() const {
+        return slabs.reservedBytes() + large;
     }
-}
\ No newline at end of file
+}
@@ -1,39 +1,140 @@
 #pragma once
 
-#include "instance.hpp"
+#include "dds/allocator.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
 
 namespace dds {
-    template<class T>
-    class DataAllocator {
+    // alignment of column and aos table buffers, a cache line and the widest simd register
+    inline constexpr size_t bufferAlignment = 64;
+
+    // Memory of the user allocator, or of aligned operator new when it has no callbacks
+    void *allocateMemory(DdsAllocator const &allocator, size_t size, size_t alignment);
+
+    void deallocateMemory(DdsAllocator const &allocator, void *p, size_t size, size_t alignment);
+
+    // Bump allocator over large blocks. Large allocations get a block of their own that
+    // deallocate returns at once, smaller ones stay until release returns everything.
+    class Arena {
     public:
-        friend bool operator==(const DataAllocator &lhs, const DataAllocator &rhs) {
-            return lhs.alloc == rhs.alloc;
+        explicit Arena(DdsAllocator allocator, size_t blockSize = 1024 * 1024);
+
+        Arena(Arena const &) = delete;
+
+        Arena &operator=(Arena const &) = delete;
+
+        ~Arena();
+
+        // null when the allocator is out of memory
+        void *allocate(size_t size, size_t alignment);
+
+        // does nothing for memory sharing a block or not from the arena
+        void deallocate(void *p);
+
+        void release();
+
+        size_t reservedBytes() const {
+            return reserved;
         }
 
-        friend bool operator!=(const DataAllocator &lhs, const DataAllocator &rhs) {
-            return !(rhs == lhs);
+        size_t usedBytes() const {
+            return used;
         }
 
+    private:
+        struct Block {
+            void *pData;
+            size_t size;
+            size_t alignment;
+            bool dedicated;
+        };
+
+        DdsAllocator allocator;
+        size_t blockSize;
+        std::vector<Block> blocks;
+        uintptr_t current = 0;
+        uintptr_t end = 0;
+        size_t reserved = 0;
+        size_t used = 0;
+    };
+
+    // Free lists of power of two size classes for small nodes like those of hash indexes.
+    // Freed nodes are reused by the pool, their slabs only go back with the pool itself.
+    // Not thread safe, every instance owns its pool.
+    class SizeClassPool {
     public:
-        using value_type = T;
+        static constexpr size_t minSize = 16;
+        static constexpr size_t maxSize = 1024;
 
-        DataAllocator(DdsAllocator alloc) : alloc(alloc) {};
+        explicit SizeClassPool(DdsAllocator allocator = {});
 
-        template<class U>
-        constexpr DataAllocator(const DataAllocator<U> &r) noexcept : alloc(r.alloc) {}
+        // larger sizes go to the allocator directly
+        void *allocate(size_t size);
 
-        [[nodiscard]] T *allocate(std::size_t n) {
-            alloc.allocate(n * sizeof(T));
-        }
+        void deallocate(void *p, size_t size);
 
-        void deallocate(T *p, std::size_t) noexcept {
-            alloc.deallocate(reinterpret_cast<uint8_t*>(p));
+        size_t reservedBytes() const;
+
+        size_t usedBytes() const {
+            return used + large;
         }
 
     private:
-        DdsAllocator alloc;
+        struct FreeNode {
+            FreeNode *pNext;
+        };
+
+        static size_t sizeClass(size_t size);
+
+        DdsAllocator allocator;
+        Arena slabs;
+        std::array<FreeNode *, 7> freeLists{};
+        size_t large = 0;
+        size_t used = 0;
     };
 
+    // Standard allocator over a SizeClassPool, plain operator new without one
+    template<typename T>
+    class PoolAllocator {
+    public:
+        using value_type = T;
+
+        PoolAllocator(SizeClassPool *pPool = nullptr) noexcept : pPool(pPool) {}
+
+        template<typename U>
+        PoolAllocator(PoolAllocator<U> const &other) noexcept : pPool(other.pPool) {}
+
+        [[nodiscard]] T *allocate(std::size_t n) {
+            if (!pPool) {
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+            void *p = pPool->allocate(n * sizeof(T));
+            if (!p) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(p);
+        }
+
+        void deallocate(T *p, std::size_t n) noexcept {
+            if (!pPool) {
+                ::operator delete(p);
+            } else {
+                pPool->deallocate(p, n * sizeof(T));
+            }
+        }
 
+        friend bool operator==(PoolAllocator const &lhs, PoolAllocator const &rhs) {
+            return lhs.pPool == rhs.pPool;
+        }
+
+        friend bool operator!=(PoolAllocator const &lhs, PoolAllocator const &rhs) {
+            return lhs.pPool != rhs.pPool;
+        }
 
+        SizeClassPool *pPool;
+    };
 }
@@ -0,0 +1,488 @@
+#include "archetype.hpp"
+#include "type.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_set>
+
+namespace dds {
+    namespace {
+        constexpr std::string_view archetypePrefix = "archetype:";
+        constexpr char const *entityColumn = "entity";
+
+        DdsResult rowCount(DdsInstance instance, DdsId entityColumn, DdsSize *pReturn) {
+            DdsColumnData column;
+            DdsResult result = ddsColumnData(instance, entityColumn, DDS_UINT64_TYPE, &column);
+            if (result == DDS_RESULT_SUCCESS) {
+                *pReturn = column.stride ? column.size / column.stride : 0;
+            }
+            return result;
+        }
+    }
+
+    Archetypes::Archetypes(DdsInstance instance) : instance(instance) {
+        DdsSize tableCount;
+        ddsGetTablesCount(instance, &tableCount);
+        for (DdsId table = 0; table != tableCount; ++table) {
+            char const *pName;
+            ddsGetTableName(instance, table, &pName);
+            if (std::string_view(pName).substr(0, archetypePrefix.size()) != archetypePrefix) {
+                continue;
+            }
+
+            DdsId const *pColumns;
+            DdsSize columnCount;
+            if (ddsGetTableColumns(instance, table, &pColumns, &columnCount) !=
+                    DDS_RESULT_SUCCESS || columnCount == 0) {
+                continue;
+            }
+
+            std::vector<DdsId> members;
+            for (size_t i = 1; i != columnCount; ++i) {
+                char const *pColumnName;
+                DdsDataType type;
+                DdsId component;
+                ddsGetColumnName(instance, pColumns[i], &pColumnName);
+                ddsGetColumnType(instance, pColumns[i], &type);
+                if (registerComponent(pColumnName, type, &component) == DDS_RESULT_SUCCESS) {
+                    members.push_back(component);
+                }
+            }
+            if (members.size() + 1 != columnCount) {
+                continue;
+            }
+
+            DdsColumnData column;
+            if (ddsColumnData(instance, pColumns[0], DDS_UINT64_TYPE, &column) !=
+                    DDS_RESULT_SUCCESS) {
+                continue;
+            }
+
+            size_t archetype = addArchetype(pName, std::move(members));
+            for (DdsId row = 0; row != column.size / column.stride; ++row) {
+                DdsEntity entity;
+                std::memcpy(&entity, column.pData + row * column.stride, sizeof(entity));
+                entities[entity] = {archetype, row};
+                nextEntity = std::max(nextEntity, entity + 1);
+            }
+        }
+    }
+
+    DdsResult Archetypes::registerComponent(char const *name, DdsDataType type,
+            DdsId *pReturn) {
+        // names make up the table names of archetypes
+        if (std::strchr(name, ',') || std::strcmp(name, entityColumn) == 0) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+        // moving entities copies cells, which would point into the heap of another column
+        if (type == DDS_STRING_TYPE) {
+            return DDS_RESULT_INVALID_TYPE;
+        }
+
+        auto iter = componentIds.find(name);
+        if (iter != componentIds.end()) {
+            if (components[iter->second].type != type) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+            *pReturn = iter->second;
+            return DDS_RESULT_SUCCESS;
+        }
+
+        *pReturn = components.size();
+        components.push_back({name, type});
+        componentIds.emplace(name, *pReturn);
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::createEntities(DdsSize count, DdsSize componentCount,
+            DdsId const *pComponents, void const *const *pValues, DdsEntity *pReturn) {
+        std::vector<DdsId> members(pComponents, pComponents + componentCount);
+        for (DdsId component : members) {
+            if (component >= components.size()) {
+                return DDS_RESULT_COLUMN_NOT_EXIST;
+            }
+        }
+
+        size_t archetype;
+        DdsResult result = archetypeFor(members, &archetype);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        std::vector<void const *> values;
+        for (DdsId component : archetypes[archetype].components) {
+            values.push_back(pValues[std::find(members.begin(), members.end(), component) -
+                    members.begin()]);
+        }
+
+        std::vector<DdsEntity> batch(count);
+        for (auto &entity : batch) {
+            entity = nextEntity++;
+        }
+
+        Resolved resolved;
+        DdsSize rows = 0;
+        result = resolve(archetype, resolved);
+        if (result == DDS_RESULT_SUCCESS) {
+            result = rowCount(instance, resolved.columns[0], &rows);
+        }
+        if (result == DDS_RESULT_SUCCESS) {
+            result = append(archetype, batch, values);
+        }
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        for (size_t i = 0; i != count; ++i) {
+            entities[batch[i]] = {archetype, rows + i};
+            pReturn[i] = batch[i];
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::destroyEntities(DdsSize count, DdsEntity const *pEntities) {
+        DdsResult result = checkEntities(count, pEntities);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        std::vector<DdsEntity> batch(pEntities, pEntities + count);
+        result = removeRows(batch);
+        for (DdsEntity entity : batch) {
+            entities.erase(entity);
+        }
+        return result;
+    }
+
+    DdsResult Archetypes::addComponent(DdsSize count, DdsEntity const *pEntities,
+            DdsId component, void const *pValues) {
+        if (component >= components.size()) {
+            return DDS_RESULT_COLUMN_NOT_EXIST;
+        }
+        DdsResult result = checkEntities(count, pEntities);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        // entities of one source archetype move together
+        std::unordered_map<size_t, std::vector<size_t>> groups;
+        for (size_t i = 0; i != count; ++i) {
+            size_t archetype = entities.at(pEntities[i]).archetype;
+            auto const &members = archetypes[archetype].components;
+            if (std::find(members.begin(), members.end(), component) != members.end()) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+            groups[archetype].push_back(i);
+        }
+
+        DdsSize valueSize = sizeOfType(components[component].type);
+        auto pBytes = static_cast<uint8_t const *>(pValues);
+
+        for (auto const &[source, indices] : groups) {
+            std::vector<DdsId> members = archetypes[source].components;
+            members.push_back(component);
+
+            size_t target;
+            result = archetypeFor(members, &target);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            std::vector<DdsEntity> batch;
+            std::vector<uint8_t> values(indices.size() * valueSize);
+            for (size_t i = 0; i != indices.size(); ++i) {
+                batch.push_back(pEntities[indices[i]]);
+                std::memcpy(values.data() + i * valueSize, pBytes + indices[i] * valueSize,
+                        valueSize);
+            }
+
+            std::vector<void const *> targetValues;
+            for (DdsId member : archetypes[target].components) {
+                targetValues.push_back(member == component ? values.data() : nullptr);
+            }
+
+            Resolved resolved;
+            DdsSize rows = 0;
+            result = resolve(target, resolved);
+            if (result == DDS_RESULT_SUCCESS) {
+                result = rowCount(instance, resolved.columns[0], &rows);
+            }
+            if (result == DDS_RESULT_SUCCESS) {
+                result = append(target, batch, targetValues);
+            }
+            if (result == DDS_RESULT_SUCCESS) {
+                result = removeRows(batch);
+            }
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            for (size_t i = 0; i != batch.size(); ++i) {
+                entities[batch[i]] = {target, rows + i};
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::removeComponent(DdsSize count, DdsEntity const *pEntities,
+            DdsId component) {
+        DdsResult result = checkEntities(count, pEntities);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        std::unordered_map<size_t, std::vector<DdsEntity>> groups;
+        for (size_t i = 0; i != count; ++i) {
+            size_t archetype = entities.at(pEntities[i]).archetype;
+            auto const &members = archetypes[archetype].components;
+            if (std::find(members.begin(), members.end(), component) == members.end()) {
+                return DDS_RESULT_COLUMN_NOT_EXIST;
+            }
+            groups[archetype].push_back(pEntities[i]);
+        }
+
+        for (auto const &[source, batch] : groups) {
+            std::vector<DdsId> members = archetypes[source].components;
+            members.erase(std::find(members.begin(), members.end(), component));
+
+            size_t target;
+            result = archetypeFor(members, &target);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            Resolved resolved;
+            DdsSize rows = 0;
+            result = resolve(target, resolved);
+            if (result == DDS_RESULT_SUCCESS) {
+                result = rowCount(instance, resolved.columns[0], &rows);
+            }
+            if (result == DDS_RESULT_SUCCESS) {
+                result = append(target, batch,
+                        std::vector<void const *>(archetypes[target].components.size()));
+            }
+            if (result == DDS_RESULT_SUCCESS) {
+                result = removeRows(batch);
+            }
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            for (size_t i = 0; i != batch.size(); ++i) {
+                entities[batch[i]] = {target, rows + i};
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::locate(DdsEntity entity, DdsId *pTable, DdsId *pRow) const {
+        auto iter = entities.find(entity);
+        if (iter == entities.end()) {
+            return DDS_RESULT_VALUE_NOT_EXIST;
+        }
+
+        *pRow = iter->second.row;
+        return ddsGetTable(instance, archetypes[iter->second.archetype].name.c_str(), pTable);
+    }
+
+    DdsResult Archetypes::query(DdsSize componentCount, DdsId const *pComponents,
+            std::vector<DdsId> &tables) const {
+        for (auto const &archetype : archetypes) {
+            auto const &members = archetype.components;
+            bool matches = std::all_of(pComponents, pComponents + componentCount,
+                    [&members](DdsId component) {
+                        return std::find(members.begin(), members.end(), component) !=
+                                members.end();
+                    });
+            if (!matches) {
+                continue;
+            }
+
+            DdsId table;
+            DdsResult result = ddsGetTable(instance, archetype.name.c_str(), &table);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            tables.push_back(table);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::resolve(size_t archetype, Resolved &resolved) const {
+        DdsResult result = ddsGetTable(instance, archetypes[archetype].name.c_str(),
+                &resolved.table);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        DdsId const *pColumns;
+        DdsSize columnCount;
+        result = ddsGetTableColumns(instance, resolved.table, &pColumns, &columnCount);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+        if (columnCount != archetypes[archetype].components.size() + 1) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+        resolved.columns.assign(pColumns, pColumns + columnCount);
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::archetypeFor(std::vector<DdsId> members, size_t *pReturn) {
+        std::sort(members.begin(), members.end(), [this](DdsId left, DdsId right) {
+            return components[left].name < components[right].name;
+        });
+        if (std::adjacent_find(members.begin(), members.end()) != members.end()) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        std::string name(archetypePrefix);
+        for (size_t i = 0; i != members.size(); ++i) {
+            name += (i ? "," : "") + components[members[i]].name;
+        }
+
+        auto iter = archetypeIds.find(name);
+        if (iter != archetypeIds.end()) {
+            *pReturn = iter->second;
+            return DDS_RESULT_SUCCESS;
+        }
+
+        std::vector<char const *> names{entityColumn};
+        std::vector<DdsDataType> types{DDS_UINT64_TYPE};
+        for (DdsId member : members) {
+            names.push_back(components[member].name.c_str());
+            types.push_back(components[member].type);
+        }
+
+        DdsId table;
+        DdsResult result = ddsCreateTable(instance, DDS_TABLE_SOA, name.c_str(), names.size(),
+                names.data(), types.data(), &table);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        *pReturn = addArchetype(std::move(name), std::move(members));
+        return DDS_RESULT_SUCCESS;
+    }
+
+    size_t Archetypes::addArchetype(std::string name, std::vector<DdsId> members) {
+        size_t archetype = archetypes.size();
+        archetypeIds.emplace(name, archetype);
+        archetypes.push_back({std::move(name), std::move(members)});
+        return archetype;
+    }
+
+    DdsResult Archetypes::append(size_t archetype, std::vector<DdsEntity> const &batch,
+            std::vector<void const *> const &pValues) {
+        if (batch.empty()) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        Resolved target;
+        DdsResult result = resolve(archetype, target);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        auto const &members = archetypes[archetype].components;
+        size_t count = batch.size();
+
+        std::vector<DdsDataType> types{DDS_UINT64_TYPE};
+        std::vector<DdsData> data{
+                {reinterpret_cast<uint8_t const *>(batch.data()), count * sizeof(DdsEntity)}};
+        std::vector<std::vector<uint8_t>> gathered;
+        gathered.reserve(members.size());
+
+        for (size_t c = 0; c != members.size(); ++c) {
+            auto const &component = components[members[c]];
+            DdsSize size = sizeOfType(component.type);
+            types.push_back(component.type);
+            if (pValues[c]) {
+                data.push_back({static_cast<uint8_t const *>(pValues[c]), count * size});
+                continue;
+            }
+
+            // one column gather per source archetype
+            auto &bytes = gathered.emplace_back(count * size);
+            std::unordered_map<size_t, DdsColumnData> sources;
+            for (size_t i = 0; i != count; ++i) {
+                Location location = entities.at(batch[i]);
+                auto iter = sources.find(location.archetype);
+                if (iter == sources.end()) {
+                    Resolved source;
+                    result = resolve(location.archetype, source);
+                    if (result != DDS_RESULT_SUCCESS) {
+                        return result;
+                    }
+
+                    auto const &sourceMembers = archetypes[location.archetype].components;
+                    size_t index = std::find(sourceMembers.begin(), sourceMembers.end(),
+                            members[c]) - sourceMembers.begin();
+                    DdsColumnData column;
+                    result = ddsColumnData(instance, source.columns[index + 1], component.type,
+                            &column);
+                    if (result != DDS_RESULT_SUCCESS) {
+                        return result;
+                    }
+                    iter = sources.emplace(location.archetype, column).first;
+                }
+
+                std::memcpy(bytes.data() + i * size,
+                        iter->second.pData + location.row * iter->second.stride, size);
+            }
+            data.push_back({bytes.data(), bytes.size()});
+        }
+
+        return ddsInsert(instance, target.table, count, types.size(), types.data(), data.data());
+    }
+
+    DdsResult Archetypes::removeRows(std::vector<DdsEntity> const &batch) {
+        std::unordered_map<size_t, std::vector<DdsId>> rows;
+        for (DdsEntity entity : batch) {
+            Location location = entities.at(entity);
+            rows[location.archetype].push_back(location.row);
+        }
+
+        for (auto &[archetype, archetypeRows] : rows) {
+            Resolved resolved;
+            DdsResult result = resolve(archetype, resolved);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            result = ddsRemoveRows(instance, resolved.table, archetypeRows.size(),
+                    archetypeRows.data());
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+
+            // the last rows moved into the gaps left below the new row count
+            DdsColumnData column;
+            result = ddsColumnData(instance, resolved.columns[0], DDS_UINT64_TYPE, &column);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            for (DdsId row : archetypeRows) {
+                if (row < column.size / column.stride) {
+                    DdsEntity moved;
+                    std::memcpy(&moved, column.pData + row * column.stride, sizeof(moved));
+                    entities[moved].row = row;
+                }
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult Archetypes::checkEntities(DdsSize count, DdsEntity const *pEntities) const {
+        std::unordered_set<DdsEntity> seen;
+        for (size_t i = 0; i != count; ++i) {
+            if (!entities.count(pEntities[i])) {
+                return DDS_RESULT_VALUE_NOT_EXIST;
+            }
+            if (!seen.insert(pEntities[i]).second) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+}
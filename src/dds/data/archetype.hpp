@@ -0,0 +1,88 @@
+#pragma once
+
+#include "dds/dds.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dds {
+    // Entities grouped by their component set, one soa table per set. A table has an entity
+    // column followed by one column per component, sorted by component name, and is named
+    // after its components, so archetypes are found through the table name index and are
+    // rebuilt from the tables when an instance is opened.
+    //
+    // Works through the C API, so inserts and removes are logged, indexed and checkpointed
+    // like any other. Table and column ids are looked up per call since deleting other tables
+    // renumbers them.
+    class Archetypes {
+    public:
+        explicit Archetypes(DdsInstance instance);
+
+        DdsResult registerComponent(char const *name, DdsDataType type, DdsId *pReturn);
+
+        DdsResult createEntities(DdsSize count, DdsSize componentCount, DdsId const *pComponents,
+                void const *const *pValues, DdsEntity *pReturn);
+
+        DdsResult destroyEntities(DdsSize count, DdsEntity const *pEntities);
+
+        DdsResult addComponent(DdsSize count, DdsEntity const *pEntities, DdsId component,
+                void const *pValues);
+
+        DdsResult removeComponent(DdsSize count, DdsEntity const *pEntities, DdsId component);
+
+        DdsResult locate(DdsEntity entity, DdsId *pTable, DdsId *pRow) const;
+
+        // archetypes having every component
+        DdsResult query(DdsSize componentCount, DdsId const *pComponents,
+                std::vector<DdsId> &tables) const;
+
+    private:
+        struct Component {
+            std::string name;
+            DdsDataType type;
+        };
+
+        struct Archetype {
+            std::string name;
+            std::vector<DdsId> components; // sorted by name, in column order
+        };
+
+        struct Location {
+            size_t archetype;
+            DdsId row;
+        };
+
+        // table and columns of an archetype, the entity column first
+        struct Resolved {
+            DdsId table;
+            std::vector<DdsId> columns;
+        };
+
+        DdsResult resolve(size_t archetype, Resolved &resolved) const;
+
+        // finds the archetype of the components or creates its table
+        DdsResult archetypeFor(std::vector<DdsId> components, size_t *pReturn);
+
+        size_t addArchetype(std::string name, std::vector<DdsId> components);
+
+        // Appends the rows of entities to an archetype. pValues holds, per component of the
+        // archetype, the values in entity order or null to copy them from the entities'
+        // current rows.
+        DdsResult append(size_t archetype, std::vector<DdsEntity> const &entities,
+                std::vector<void const *> const &pValues);
+
+        // Removes the rows of entities from their archetypes, the moved last rows keep their
+        // locations up to date
+        DdsResult removeRows(std::vector<DdsEntity> const &entities);
+
+        DdsResult checkEntities(DdsSize count, DdsEntity const *pEntities) const;
+
+        DdsInstance instance;
+        std::vector<Component> components;
+        std::unordered_map<std::string, DdsId> componentIds;
+        std::vector<Archetype> archetypes;
+        std::unordered_map<std::string, size_t> archetypeIds;
+        std::unordered_map<DdsEntity, Location> entities;
+        DdsEntity nextEntity = 0;
+    };
+}
@@ -0,0 +1,40 @@
+#include "arena.hpp"
+#include <cstring>
+
+namespace dds {
+    DdsResult ArenaStore::reserve(data::vector<uint8_t> &bytes, DdsId table, size_t size) {
+        size_t capacity = bytes.allocated_size_;
+        bool aligned = reinterpret_cast<uintptr_t>(bytes.data()) % bufferAlignment == 0;
+        if (aligned && size <= capacity) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        capacity = std::max(size, capacity * 2);
+        capacity = (capacity + bufferAlignment - 1) / bufferAlignment * bufferAlignment;
+        auto pData = static_cast<uint8_t *>(arenas[table]->allocate(capacity, bufferAlignment));
+        if (!pData) {
+            return DDS_RESULT_OUT_OF_MEMORY;
+        }
+
+        size_t used = bytes.size();
+        if (used != 0) {
+            std::memcpy(pData, bytes.data(), used);
+        }
+        arenas[table]->deallocate(bytes.data());
+        bytes.reset();
+        pointAt(bytes, pData, used, capacity);
+        return DDS_RESULT_SUCCESS;
+    }
+
+    void ArenaStore::onTablesInsert(size_t count) {
+        for (size_t i = 0; i != count; ++i) {
+            arenas.push_back(std::make_unique<Arena>(allocator));
+        }
+    }
+
+    void ArenaStore::onTableRemove(size_t table) {
+        // the buffers of the table are gone with its columns, all at once
+        std::swap(arenas[table], arenas.back());
+        arenas.pop_back();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "instance.hpp"
+#include <memory>
+#include <vector>
+
+namespace dds {
+    // Column and aos table buffers of an instance created with a DdsAllocator. Every table
+    // allocates bufferAlignment aligned buffers from an arena of its own. A buffer that has to
+    // grow moves to a bigger one, and deleting the table releases the arena in one call.
+    // Outgrown buffers with a block of their own go back to the allocator right away. Smaller
+    // ones stay until the table is deleted, as capacities double less than a quarter block per
+    // column.
+    class ArenaStore {
+    public:
+        explicit ArenaStore(DdsAllocator allocator) : allocator(allocator) {}
+
+        // Makes room for size bytes, moving buffers that are too small or not aligned
+        DdsResult reserve(data::vector<uint8_t> &bytes, DdsId table, size_t size);
+
+        void onTablesInsert(size_t count);
+
+        void onTableRemove(size_t table);
+
+        Arena const &arena(DdsId table) const {
+            return *arenas[table];
+        }
+
+    private:
+        DdsAllocator allocator;
+        std::vector<std::unique_ptr<Arena>> arenas;
+    };
+}
@@ -0,0 +1,374 @@
+#include "arrow.hpp"
+#include "strings.hpp"
+#include "table.hpp"
+#include "type.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace dds {
+    namespace {
+        // Every exported schema and array node owns its own private data, so a consumer may
+        // move children out and release them independently of the parent
+        struct SchemaData {
+            std::string format;
+            std::string name;
+            std::vector<ArrowSchema> children;
+            std::vector<ArrowSchema *> pointers;
+        };
+
+        struct ArrayData {
+            std::vector<void const *> buffers;
+            std::vector<std::vector<uint8_t>> owned;
+            std::vector<ArrowArray> children;
+            std::vector<ArrowArray *> pointers;
+        };
+
+        void releaseSchema(ArrowSchema *pSchema) {
+            auto pData = static_cast<SchemaData *>(pSchema->private_data);
+            for (auto &child : pData->children) {
+                // moved out children are marked released already
+                if (child.release) {
+                    child.release(&child);
+                }
+            }
+            delete pData;
+            pSchema->release = nullptr;
+        }
+
+        void releaseArray(ArrowArray *pArray) {
+            auto pData = static_cast<ArrayData *>(pArray->private_data);
+            for (auto &child : pData->children) {
+                if (child.release) {
+                    child.release(&child);
+                }
+            }
+            delete pData;
+            pArray->release = nullptr;
+        }
+
+        SchemaData &initSchema(ArrowSchema &schema, std::string format, std::string name,
+                size_t childCount) {
+            auto pData = new SchemaData{std::move(format), std::move(name),
+                    std::vector<ArrowSchema>(childCount), {}};
+            for (auto &child : pData->children) {
+                pData->pointers.push_back(&child);
+            }
+            schema = ArrowSchema{pData->format.c_str(), pData->name.c_str(), nullptr, 0,
+                    static_cast<int64_t>(childCount), pData->pointers.data(), nullptr,
+                    releaseSchema, pData};
+            return *pData;
+        }
+
+        // buffers that are owned are set by the caller after moving them into the node
+        ArrayData &initArray(ArrowArray &array, DdsSize length, std::vector<void const *> buffers,
+                size_t childCount) {
+            auto pData = new ArrayData{std::move(buffers), {}, std::vector<ArrowArray>(childCount),
+                    {}};
+            for (auto &child : pData->children) {
+                pData->pointers.push_back(&child);
+            }
+            array = ArrowArray{static_cast<int64_t>(length), 0, 0,
+                    static_cast<int64_t>(pData->buffers.size()), static_cast<int64_t>(childCount),
+                    pData->buffers.data(), pData->pointers.data(), nullptr, releaseArray, pData};
+            return *pData;
+        }
+
+        // format of a number, or of the elements of a vector or matrix
+        std::string numberFormat(DdsDataType type) {
+            switch (type) {
+                case DDS_DOUBLE_TYPE:
+                    return "g";
+                case DDS_INT32_TYPE:
+                    return "i";
+                case DDS_UINT32_TYPE:
+                    return "I";
+                case DDS_INT64_TYPE:
+                    return "l";
+                case DDS_UINT64_TYPE:
+                    return "L";
+                default:
+                    return "f";
+            }
+        }
+
+        std::string listFormat(DdsDataType type) {
+            return "+w:" + std::to_string(componentCount(type));
+        }
+
+        bool isValid(ArrowArray const &array, int64_t index) {
+            auto pBitmap = static_cast<uint8_t const *>(array.buffers[0]);
+            return array.null_count == 0 || !pBitmap || (pBitmap[index / 8] >> (index % 8)) & 1;
+        }
+
+        // Values of a column one after another, copied from the soa data or gathered from the
+        // rows of an aos table. The export owns them, so it outlives later changes of the table.
+        std::vector<uint8_t> columnValues(InstanceData &data, InstanceHelpers &components,
+                DdsId column, DdsSize rows) {
+            DdsSize size = sizeOfType(data.columns.type[column]);
+            auto aosId = components.tableAosData[data.columns.table[column]];
+            if (!aosId) {
+                uint8_t const *pData = data.columns.soaColumnData[column].data();
+                return std::vector<uint8_t>(pData, pData + rows * size);
+            }
+
+            DdsSize rowSize = data.aosTables.rowSize[*aosId];
+            uint8_t const *pRow = data.aosTables.data[*aosId].data()
+                                  + data.columns.aosColumnOffset[column];
+            std::vector<uint8_t> gathered(rows * size);
+            for (DdsSize row = 0; row != rows; ++row) {
+                std::memcpy(gathered.data() + row * size, pRow + row * rowSize, size);
+            }
+            return gathered;
+        }
+
+        // value(row) is the string_view of a row
+        template<typename OffsetT, typename FnT>
+        void exportStrings(ArrowArray &array, DdsSize rows, FnT &&value) {
+            std::vector<uint8_t> offsets((rows + 1) * sizeof(OffsetT));
+            std::vector<uint8_t> chars;
+
+            OffsetT offset = 0;
+            for (DdsSize row = 0; row != rows; ++row) {
+                std::string_view rowChars = value(row);
+                std::memcpy(offsets.data() + row * sizeof(OffsetT), &offset, sizeof(OffsetT));
+                chars.insert(chars.end(), rowChars.begin(), rowChars.end());
+                offset += static_cast<OffsetT>(rowChars.size());
+            }
+            std::memcpy(offsets.data() + rows * sizeof(OffsetT), &offset, sizeof(OffsetT));
+
+            auto &arrayData = initArray(array, rows, {nullptr, nullptr, nullptr}, 0);
+            arrayData.owned.push_back(std::move(offsets));
+            arrayData.owned.push_back(std::move(chars));
+            arrayData.buffers[1] = arrayData.owned[0].data();
+            arrayData.buffers[2] = arrayData.owned[1].data();
+        }
+
+        void exportColumn(ArrowSchema &schema, ArrowArray &array, DdsDataType type,
+                std::string name, std::vector<uint8_t> values, DdsSize rows,
+                StringHeap const &heap) {
+            uint8_t const *pValues = values.data();
+            DdsSize size = sizeOfType(type);
+            if (DdsSize capacity = stringCapacity(type)) {
+                auto value = [capacity, pValues, size](DdsSize row) {
+                    uint8_t const *pValue = pValues + row * size;
+                    DdsSize length;
+                    std::memcpy(&length, pValue, sizeof(length));
+                    auto pChars = reinterpret_cast<char const *>(pValue)
+                                  + offsetof(DdsString16, str);
+                    return std::string_view(pChars, std::min(length, capacity));
+                };
+                // large utf8 only when the characters do not fit 32 bit offsets
+                if (rows * capacity <= static_cast<DdsSize>(std::numeric_limits<int32_t>::max())) {
+                    initSchema(schema, "u", std::move(name), 0);
+                    exportStrings<int32_t>(array, rows, value);
+                } else {
+                    initSchema(schema, "U", std::move(name), 0);
+                    exportStrings<int64_t>(array, rows, value);
+                }
+                return;
+            }
+
+            if (type == DDS_STRING_TYPE) {
+                // the heap may hold garbage, so it only bounds the characters
+                auto value = [&heap, pValues, size](DdsSize row) {
+                    return loadString(heap, pValues + row * size);
+                };
+                auto maxChars = static_cast<DdsSize>(std::numeric_limits<int32_t>::max());
+                if (heap.chars.size() <= maxChars) {
+                    initSchema(schema, "u", std::move(name), 0);
+                    exportStrings<int32_t>(array, rows, value);
+                } else {
+                    initSchema(schema, "U", std::move(name), 0);
+                    exportStrings<int64_t>(array, rows, value);
+                }
+                return;
+            }
+
+            ArrowSchema *pValueSchema = &schema;
+            ArrowArray *pValueArray = &array;
+            DdsSize components = componentCount(type);
+            if (components != 1) {
+                // vectors and matrices are fixed size lists of floats
+                auto &schemaData = initSchema(schema, listFormat(type), std::move(name), 1);
+                auto &arrayData = initArray(array, rows, {nullptr}, 1);
+                pValueSchema = &schemaData.children[0];
+                pValueArray = &arrayData.children[0];
+                name = "item";
+            }
+
+            initSchema(*pValueSchema, numberFormat(type), std::move(name), 0);
+            auto &arrayData = initArray(*pValueArray, rows * components, {nullptr, nullptr}, 0);
+            arrayData.owned.push_back(std::move(values));
+            arrayData.buffers[1] = arrayData.owned[0].data();
+        }
+
+        template<typename OffsetT>
+        void importStrings(ArrowArray const &array, int64_t first, DdsDataType type,
+                DdsSize rows, uint8_t *pDst) {
+            auto pOffsets = static_cast<OffsetT const *>(array.buffers[1]);
+            auto pChars = static_cast<char const *>(array.buffers[2]);
+            DdsSize size = sizeOfType(type);
+            for (DdsSize row = 0; row != rows; ++row) {
+                int64_t index = first + static_cast<int64_t>(row);
+                if (isValid(array, index)) {
+                    auto begin = static_cast<size_t>(pOffsets[index]);
+                    auto end = static_cast<size_t>(pOffsets[index + 1]);
+                    storeString(pDst + row * size, type, pChars + begin, end - begin);
+                }
+            }
+        }
+
+        template<typename OffsetT>
+        void importStringValues(ArrowArray const &array, int64_t first, DdsSize rows,
+                StringValues &values) {
+            auto pOffsets = static_cast<OffsetT const *>(array.buffers[1]);
+            auto pChars = static_cast<char const *>(array.buffers[2]);
+            for (DdsSize row = 0; row != rows; ++row) {
+                int64_t index = first + static_cast<int64_t>(row);
+                if (isValid(array, index)) {
+                    auto begin = static_cast<size_t>(pOffsets[index]);
+                    auto end = static_cast<size_t>(pOffsets[index + 1]);
+                    values.add({pChars + begin, end - begin});
+                } else {
+                    values.add({});
+                }
+            }
+        }
+
+        // DDS_STRING_TYPE columns take a buffer of values like ddsInsert, nulls are empty
+        DdsResult importStringColumn(ArrowSchema const &schema, ArrowArray const &array,
+                int64_t parentOffset, DdsSize rows, std::vector<uint8_t> &column) {
+            std::string_view format = schema.format;
+            int64_t first = parentOffset + array.offset;
+            StringValues values;
+            if (format == "u") {
+                importStringValues<int32_t>(array, first, rows, values);
+            } else if (format == "U") {
+                importStringValues<int64_t>(array, first, rows, values);
+            } else {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+            column = values.bytes();
+            return DDS_RESULT_SUCCESS;
+        }
+
+        // parentOffset is the offset of the struct array, which applies to its children too
+        DdsResult importColumn(ArrowSchema const &schema, ArrowArray const &array,
+                int64_t parentOffset, DdsDataType type, DdsSize rows, uint8_t *pDst) {
+            std::string_view format = schema.format;
+            int64_t first = parentOffset + array.offset;
+            DdsSize size = sizeOfType(type);
+
+            if (stringCapacity(type)) {
+                if (format == "u") {
+                    importStrings<int32_t>(array, first, type, rows, pDst);
+                } else if (format == "U") {
+                    importStrings<int64_t>(array, first, type, rows, pDst);
+                } else {
+                    return DDS_RESULT_INVALID_TYPE;
+                }
+                return DDS_RESULT_SUCCESS;
+            }
+
+            ArrowArray const *pValues = &array;
+            int64_t firstValue = first;
+            DdsSize components = componentCount(type);
+            if (components != 1) {
+                if (format != listFormat(type) || schema.n_children != 1
+                    || std::string_view(schema.children[0]->format) != "f") {
+                    return DDS_RESULT_INVALID_TYPE;
+                }
+                pValues = array.children[0];
+                firstValue = pValues->offset + first * static_cast<int64_t>(components);
+            } else if (format != numberFormat(type)) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+
+            auto pSource = static_cast<uint8_t const *>(pValues->buffers[1])
+                           + static_cast<DdsSize>(firstValue) * (size / components);
+            if (array.null_count == 0 && pValues->null_count == 0) {
+                std::memcpy(pDst, pSource, rows * size);
+                return DDS_RESULT_SUCCESS;
+            }
+
+            // null values, including single null elements of a vector, stay zero
+            for (DdsSize row = 0; row != rows; ++row) {
+                if (!isValid(array, first + static_cast<int64_t>(row))) {
+                    continue;
+                }
+                for (DdsSize i = 0; i != components; ++i) {
+                    DdsSize element = row * components + i;
+                    if (isValid(*pValues, firstValue + static_cast<int64_t>(element))) {
+                        DdsSize elementSize = size / components;
+                        std::memcpy(pDst + element * elementSize, pSource + element * elementSize,
+                                elementSize);
+                    }
+                }
+            }
+            return DDS_RESULT_SUCCESS;
+        }
+    }
+
+    DdsResult exportArrow(InstanceData &data, InstanceHelpers &components, DdsId table,
+            ArrowSchema *pSchema, ArrowArray *pArray) {
+        auto const &tableColumns = components.tableColumns[table];
+        DdsSize rows = rowCount(components, data, table);
+
+        auto &schemaData = initSchema(*pSchema, "+s", data.tables.name[table].data(),
+                tableColumns.size());
+        auto &arrayData = initArray(*pArray, rows, {nullptr}, tableColumns.size());
+        for (size_t i = 0; i != tableColumns.size(); ++i) {
+            DdsId column = tableColumns[i];
+            exportColumn(schemaData.children[i], arrayData.children[i], data.columns.type[column],
+                    data.columns.name[column].data(), columnValues(data, components, column, rows),
+                    rows, data.columns.stringHeap[column]);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult importArrow(InstanceData &data, InstanceHelpers &components, DdsId table,
+            ArrowSchema const &schema, ArrowArray const &array,
+            std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount) {
+        if (std::string_view(schema.format) != "+s" || schema.n_children != array.n_children) {
+            return DDS_RESULT_INVALID_TYPE;
+        }
+
+        auto const &tableColumns = components.tableColumns[table];
+        rowCount = static_cast<DdsSize>(array.length);
+        columns.assign(tableColumns.size(), {});
+        for (size_t i = 0; i != tableColumns.size(); ++i) {
+            // zero offsets are empty strings
+            DdsDataType type = data.columns.type[tableColumns[i]];
+            columns[i].resize(type == DDS_STRING_TYPE ? (rowCount + 1) * sizeof(DdsSize)
+                                                      : rowCount * sizeOfType(type));
+        }
+
+        for (int64_t child = 0; child != schema.n_children; ++child) {
+            ArrowSchema const &childSchema = *schema.children[child];
+            auto iter = std::find_if(tableColumns.begin(), tableColumns.end(), [&](DdsId column) {
+                return data.columns.name[column] == childSchema.name;
+            });
+            if (iter == tableColumns.end()) {
+                return DDS_RESULT_COLUMN_NOT_EXIST;
+            }
+            auto i = static_cast<size_t>(iter - tableColumns.begin());
+
+            DdsDataType type = data.columns.type[tableColumns[i]];
+            DdsResult result;
+            if (type == DDS_STRING_TYPE) {
+                result = importStringColumn(childSchema, *array.children[child], array.offset,
+                        rowCount, columns[i]);
+            } else {
+                result = importColumn(childSchema, *array.children[child], array.offset, type,
+                        rowCount, columns[i].data());
+            }
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "helpers.hpp"
+#include "dds/arrow.h"
+#include <vector>
+
+namespace dds {
+    DdsResult exportArrow(InstanceData &data, InstanceHelpers &components, DdsId table,
+            ArrowSchema *pSchema, ArrowArray *pArray);
+
+    // Converts the rows of a struct array into one buffer per table column
+    DdsResult importArrow(InstanceData &data, InstanceHelpers &components, DdsId table,
+            ArrowSchema const &schema, ArrowArray const &array,
+            std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount);
+}
@@ -0,0 +1,52 @@
+#include "cluster.hpp"
+#include <cstring>
+
+namespace dds {
+    namespace {
+        // first row for which isBefore is false, isBefore holds for a prefix of the rows
+        template<typename T, typename FnT>
+        size_t partitionRow(DdsColumnData const &column, FnT &&isBefore) {
+            size_t first = 0;
+            size_t count = column.stride ? column.size / column.stride : 0;
+            while (count != 0) {
+                size_t step = count / 2;
+                T value;
+                std::memcpy(&value, column.pData + (first + step) * column.stride, sizeof(T));
+                if (isBefore(value)) {
+                    first += step + 1;
+                    count -= step + 1;
+                } else {
+                    count = step;
+                }
+            }
+            return first;
+        }
+
+        template<typename T>
+        DdsResult childRange(DdsColumnData const &column, DdsId parent, DdsId *pOffset,
+                DdsSize *pCount) {
+            auto key = static_cast<T>(parent);
+            size_t begin = partitionRow<T>(column, [key](T row) { return row < key; });
+            size_t end = partitionRow<T>(column, [key](T row) { return !(key < row); });
+            *pOffset = begin;
+            *pCount = end - begin;
+            return DDS_RESULT_SUCCESS;
+        }
+    }
+
+    DdsResult childRange(DdsColumnData const &column, DdsDataType type, DdsId parent,
+            DdsId *pOffset, DdsSize *pCount) {
+        switch (type) {
+            case DDS_INT32_TYPE:
+                return childRange<int32_t>(column, parent, pOffset, pCount);
+            case DDS_UINT32_TYPE:
+                return childRange<uint32_t>(column, parent, pOffset, pCount);
+            case DDS_INT64_TYPE:
+                return childRange<int64_t>(column, parent, pOffset, pCount);
+            case DDS_UINT64_TYPE:
+                return childRange<uint64_t>(column, parent, pOffset, pCount);
+            default:
+                return DDS_RESULT_INVALID_TYPE;
+        }
+    }
+}
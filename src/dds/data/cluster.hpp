@@ -0,0 +1,9 @@
+#pragma once
+
+#include "dds/dds.h"
+
+namespace dds {
+    // Rows [*pOffset, *pOffset + *pCount) holding parent in an integer column sorted ascending
+    DdsResult childRange(DdsColumnData const &column, DdsDataType type, DdsId parent,
+            DdsId *pOffset, DdsSize *pCount);
+}
@@ -1,4 +1,5 @@
 #include "column.hpp"
+#include "strings.hpp"
 #include "type.hpp"
 
 namespace dds {
@@ -6,7 +7,7 @@ namespace dds {
             DdsSize columnCount, char const *const *pColumnNames, DdsDataType const *pColumnTypes) {
         for (size_t i = 0; i != columnCount; ++i) {
             components.columns.insert(pColumnNames[i], pColumnTypes[i], table, 0,
-                    data::vector<uint8_t>{});
+                    data::vector<uint8_t>{}, StringHeap{});
         }
         return DDS_RESULT_SUCCESS;
     }
@@ -16,18 +17,17 @@ namespace dds {
         auto &rowSize = data.aosTables.rowSize[aosId];
         auto const &columns = components.tableColumns[table];
 
-        // C requires that structure size must be aligned at largest member size
-        DdsSize rowSizeAlignment = 0;
+        // C requires that structure size must be aligned at largest member alignment
+        DdsSize rowSizeAlignment = 1;
 
         for (size_t i = 0; i != columns.size(); ++i) {
             DdsDataType type = data.columns.type[columns[i]];
-            DdsSize typeSize = sizeOfType(type);
 
-            data.columns.aosColumnOffset[columns[i]] = rowSize;
             rowSize = aline(rowSize, cAlignment(type));
-            rowSize += typeSize;
+            data.columns.aosColumnOffset[columns[i]] = rowSize;
+            rowSize += sizeOfType(type);
 
-            rowSizeAlignment = std::max(rowSizeAlignment, typeSize);
+            rowSizeAlignment = std::max(rowSizeAlignment, cAlignment(type));
         }
 
         rowSize = aline(rowSize, rowSizeAlignment);
@@ -43,12 +43,17 @@ namespace dds {
             DdsDataType type = data.columns.type[columns[i]];
             if (type == DDS_STRING16_TYPE ||
                 type == DDS_STRING64_TYPE ||
-                type == DDS_STRING256_TYPE) {
+                type == DDS_STRING256_TYPE ||
+                type == DDS_STRING_TYPE) {
                 return DDS_RESULT_INVALID_TYPE;
             }
             rowSize = aline(rowSize, std140Alignment(type));
+            data.columns.aosColumnOffset[columns[i]] = rowSize;
+            rowSize += sizeOfType(type);
         }
 
+        // array elements of a std140 block start at multiples of a vec4
+        rowSize = aline(rowSize, 16);
         return DDS_RESULT_SUCCESS;
     }
 
@@ -58,6 +63,7 @@ namespace dds {
         auto const &columns = components.tableColumns[table];
 
         for (size_t i = 0; i != columns.size(); ++i) {
+            data.columns.aosColumnOffset[columns[i]] = rowSize;
             rowSize += sizeOfType(data.columns.type[columns[i]]);
         }
 
@@ -85,10 +91,21 @@ namespace dds {
             if (data.columns.type[column] != pColumnTypes[i]) {
                 return DDS_RESULT_INVALID_TYPE;
             }
-            if (dds::sizeOfType(data.columns.type[i]) * count != pColumnData[i].size) {
+            if (pColumnTypes[i] == DDS_STRING_TYPE) {
+                if (!checkStringValues(count, pColumnData[i])) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+                DdsSize heapSize = data.columns.stringHeap[column].chars.size();
+                if (pColumnData[i].size > maxStringHeap - heapSize) {
+                    return DDS_RESULT_OUT_OF_MEMORY;
+                }
+                continue;
+            }
+            if (dds::sizeOfType(data.columns.type[column]) * count != pColumnData[i].size) {
                 return DDS_RESULT_INVALID_DATA;
             }
         }
+        return DDS_RESULT_SUCCESS;
     }
 
     DdsColumnData aosColumnData(InstanceData &data, DdsId aosId, DdsId column) {
@@ -105,7 +122,7 @@ namespace dds {
 
     DdsColumnData soaColumnData(InstanceData &data, DdsId column) {
         auto &bytes = data.columns.soaColumnData[column];
-        DdsSize typeSize = data.columns.type[column];
+        DdsSize typeSize = sizeOfType(data.columns.type[column]);
 
         return DdsColumnData{
                 bytes.data(),
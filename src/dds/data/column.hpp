@@ -1,6 +1,6 @@
 #pragma once
 
-#include "instance.hpp"
+#include "helpers.hpp"
 
 namespace dds {
     DdsResult createColumns(InstanceHelpers &components, DdsId table, DdsSize columnCount,
@@ -0,0 +1,55 @@
+#include "commands.hpp"
+#include <algorithm>
+
+namespace dds {
+    DdsSize CommandBuffer::push(void const *pData, DdsSize size) {
+        DdsSize offset = arena.size();
+        auto beg = reinterpret_cast<uint8_t const *>(pData);
+        arena.insert(arena.end(), beg, beg + size);
+        return offset;
+    }
+
+    void CommandBuffer::clear() {
+        commands.clear();
+        arena.clear();
+    }
+
+    CommandBuffers::CommandBuffers() : id(nextId++) {}
+
+    CommandBuffer &CommandBuffers::local() {
+        // ids are never reused, so entries of deleted instances just never match again
+        thread_local std::vector<std::pair<uint64_t, CommandBuffer *>> cache;
+
+        for (auto const &[bufferId, pBuffer] : cache) {
+            if (bufferId == id) {
+                return *pBuffer;
+            }
+        }
+
+        std::lock_guard lock(mutex);
+        auto &buffer = buffers.emplace_back(std::make_unique<CommandBuffer>());
+        buffer->thread = buffers.size() - 1;
+        cache.emplace_back(id, buffer.get());
+        return *buffer;
+    }
+
+    std::vector<CommandRef> collectCommands(CommandBuffers &buffers) {
+        std::vector<CommandRef> result;
+        buffers.forEach([&result](CommandBuffer const &buffer) {
+            for (size_t i = 0; i != buffer.commands.size(); ++i) {
+                result.push_back({&buffer.commands[i], &buffer, i});
+            }
+        });
+
+        std::sort(result.begin(), result.end(), [](CommandRef const &l, CommandRef const &r) {
+            if (l.command->sortKey != r.command->sortKey) {
+                return l.command->sortKey < r.command->sortKey;
+            }
+            if (l.buffer->thread != r.buffer->thread) {
+                return l.buffer->thread < r.buffer->thread;
+            }
+            return l.sequence < r.sequence;
+        });
+        return result;
+    }
+}
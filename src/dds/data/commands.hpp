@@ -0,0 +1,74 @@
+#pragma once
+
+#include "instance.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dds {
+    enum class CommandType : uint8_t {
+        Insert,
+        Remove,
+        Update,
+    };
+
+    struct Command {
+        CommandType type;
+        DdsId target; // table for insert and remove, column for update
+        DdsId sortKey;
+        DdsId position; // row for remove and update
+        DdsSize count; // rows for insert
+        DdsSize dataOffset; // payload position in the owning buffer arena
+        DdsSize dataSize;
+    };
+
+    // Commands recorded by a single thread. Payloads are appended to the arena, so recording
+    // never touches shared state.
+    struct CommandBuffer {
+        size_t thread;
+        std::vector<Command> commands;
+        std::vector<uint8_t> arena;
+
+        DdsSize push(void const *pData, DdsSize size);
+
+        void clear();
+    };
+
+    class CommandBuffers {
+    public:
+        CommandBuffers();
+
+        // Buffer of the calling thread, created on first use. The lock is taken only then.
+        CommandBuffer &local();
+
+        template<typename FnT>
+        void forEach(FnT &&f) {
+            std::lock_guard lock(mutex);
+            for (auto &buffer : buffers) {
+                f(*buffer);
+            }
+        }
+
+    private:
+        static inline std::atomic<uint64_t> nextId{0};
+
+        uint64_t id;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<CommandBuffer>> buffers;
+    };
+
+    struct CommandRef {
+        Command const *command;
+        CommandBuffer const *buffer;
+        size_t sequence;
+
+        uint8_t const *data() const {
+            return buffer->arena.data() + command->dataOffset;
+        }
+    };
+
+    // All recorded commands ordered by sort key, then by recording order within a thread.
+    // Commands from different threads sharing a sort key are ordered by thread registration.
+    std::vector<CommandRef> collectCommands(CommandBuffers &buffers);
+}
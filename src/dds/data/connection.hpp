@@ -1,16 +1,20 @@
 #pragma once
 
-#include "dds/data/connection.hpp"
+#include "search.hpp"
+#include <tuple>
+#include <unordered_map>
 
 namespace dds {
     struct ColumnConnections {
         std::unordered_map<DdsId, dds::Connection> single{};
         std::unordered_map<DdsId, dds::MultiConnection> multi{};
+        std::unordered_map<DdsId, DdsId> parents{}; // parent table of every connected column
     };
 
     template<typename C1, typename T1, typename C2>
     DdsResult insertConnection(ColumnConnections &connections, DdsId column, DdsConnectionType type,
-            C1 &childConnection, T1 &childParentMember, C2 &parentConnection) {
+            C1 &childConnection, T1 &childParentMember, C2 &parentConnection,
+            size_t parentCount) {
         auto singleIter = connections.single.find(column);
         if (singleIter != connections.single.end()) {
             return DDS_RESULT_ALREADY_CONNECTED;
@@ -21,9 +25,13 @@ namespace dds {
         }
 
         if (type == DDS_CONNECTION_SINGLE) {
-            connections.single.emplace(childConnection, childParentMember, parentConnection);
+            connections.single.emplace(std::piecewise_construct, std::forward_as_tuple(column),
+                    std::forward_as_tuple(childConnection, childParentMember, parentConnection,
+                            parentCount));
         } else {
-            connections.multi.emplace(childConnection, childParentMember, parentConnection);
+            connections.multi.emplace(std::piecewise_construct, std::forward_as_tuple(column),
+                    std::forward_as_tuple(childConnection, childParentMember, parentConnection,
+                            parentCount));
         }
 
         return DDS_RESULT_SUCCESS;
@@ -60,12 +68,21 @@ namespace dds {
         }
     }
 
+    // Column holding parent row positions, which only integer columns can
     template<typename FnT>
-    DdsResult getTypeRange(InstanceData &data, DdsDataType type, SearchHelpers &components,
+    DdsResult getTypeRange(InstanceData &data, DdsDataType type, InstanceHelpers &components,
             DdsId column, FnT &&f) {
-        return dds::getType(type, [&data, &components, &f, column](auto val) {
-            using T = std::decay_t<decltype(val)>;
-            return dds::getRange<T>(data, components, column, f);
-        });
+        switch (type) {
+            case DDS_INT32_TYPE:
+                return dds::getRange<int32_t>(data, components, column, f);
+            case DDS_UINT32_TYPE:
+                return dds::getRange<uint32_t>(data, components, column, f);
+            case DDS_INT64_TYPE:
+                return dds::getRange<int64_t>(data, components, column, f);
+            case DDS_UINT64_TYPE:
+                return dds::getRange<uint64_t>(data, components, column, f);
+            default:
+                return DDS_RESULT_INVALID_TYPE;
+        }
     }
 }
\ No newline at end of file
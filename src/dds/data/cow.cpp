@@ -0,0 +1,33 @@
+#include "cow.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dds {
+    CowMapping::CowMapping(char const *path) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            auto size = static_cast<size_t>(info.st_size);
+            void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                pData = static_cast<uint8_t *>(p);
+                mappedSize = size;
+            }
+        }
+
+        // the mapping keeps its own reference to the file
+        ::close(fd);
+    }
+
+    CowMapping::~CowMapping() {
+        if (pData) {
+            ::munmap(pData, mappedSize);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dds {
+    // Snapshot file mapped private and writable. Pages stay shared with the page cache until
+    // they are written, which copies just the touched page into anonymous memory. The file
+    // itself is never modified.
+    class CowMapping {
+    public:
+        explicit CowMapping(char const *path);
+
+        CowMapping(CowMapping const &) = delete;
+
+        CowMapping &operator=(CowMapping const &) = delete;
+
+        ~CowMapping();
+
+        bool isOpen() const {
+            return pData != nullptr;
+        }
+
+        uint8_t *begin() const {
+            return pData;
+        }
+
+        uint8_t *end() const {
+            return pData + mappedSize;
+        }
+
+    private:
+        uint8_t *pData = nullptr;
+        size_t mappedSize = 0;
+    };
+}
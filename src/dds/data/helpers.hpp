@@ -0,0 +1,26 @@
+#pragma once
+
+#include "instance.hpp"
+#include "dds/helpers/Component.hpp"
+#include "dds/helpers/Connection.hpp"
+#include "dds/helpers/IdMap.hpp"
+#include "dds/helpers/MultiConnection.hpp"
+
+namespace dds {
+    // Catalog of an instance and the lookups kept up to date by its components. The lookups
+    // register callbacks on the components that capture their addresses, so it never moves.
+    struct InstanceHelpers {
+        explicit InstanceHelpers(InstanceData &data);
+
+        InstanceHelpers(InstanceHelpers const &) = delete;
+
+        InstanceHelpers &operator=(InstanceHelpers const &) = delete;
+
+        StructComponentType<TableData> tables;
+        StructComponentType<ColumnData> columns;
+        StructComponentType<AosTableData> aosTables;
+        IdMap<data::string> tableNameIndex;
+        BasicMultiConnection<DdsId> tableColumns; // ddsGetTableColumns hands out its children
+        Connection tableAosData;
+    };
+}
@@ -0,0 +1,295 @@
+#include "import.hpp"
+#include "cow.hpp"
+#include "type.hpp"
+#include "dds/helpers/parallel.hpp"
+#include "dds/helpers/scan.hpp"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+namespace dds {
+    namespace {
+        // smallest piece of a file parsed by one thread
+        constexpr size_t minChunkSize = 1024 * 1024;
+
+        struct ImportColumn {
+            DdsDataType type;
+            uint8_t *pData;
+            DdsSize size;
+        };
+
+        template<typename T>
+        bool storeNumber(char const *pBegin, char const *pEnd, uint8_t *pDst) {
+            while (pBegin != pEnd && (*pBegin == ' ' || *pBegin == '\t')) {
+                ++pBegin;
+            }
+            while (pEnd != pBegin && (pEnd[-1] == ' ' || pEnd[-1] == '\t')) {
+                --pEnd;
+            }
+            if (pBegin != pEnd && *pBegin == '+') {
+                ++pBegin;
+            }
+
+            // an empty field is zero
+            T value{};
+            if (pBegin != pEnd) {
+                auto [pParsed, error] = std::from_chars(pBegin, pEnd, value);
+                if (error != std::errc() || pParsed != pEnd) {
+                    return false;
+                }
+            }
+            std::memcpy(pDst, &value, sizeof(T));
+            return true;
+        }
+
+        bool storeField(DdsDataType type, char const *pBegin, char const *pEnd, uint8_t *pDst) {
+            switch (type) {
+                case DDS_STRING16_TYPE:
+                case DDS_STRING64_TYPE:
+                case DDS_STRING256_TYPE:
+                    storeString(pDst, type, pBegin, static_cast<size_t>(pEnd - pBegin));
+                    return true;
+                case DDS_DOUBLE_TYPE:
+                    return storeNumber<double>(pBegin, pEnd, pDst);
+                case DDS_INT32_TYPE:
+                    return storeNumber<int32_t>(pBegin, pEnd, pDst);
+                case DDS_UINT32_TYPE:
+                    return storeNumber<uint32_t>(pBegin, pEnd, pDst);
+                case DDS_INT64_TYPE:
+                    return storeNumber<int64_t>(pBegin, pEnd, pDst);
+                case DDS_UINT64_TYPE:
+                    return storeNumber<uint64_t>(pBegin, pEnd, pDst);
+                default:
+                    // float and the float components of vectors and matrices
+                    return storeNumber<float>(pBegin, pEnd, pDst);
+            }
+        }
+
+        // Parses the line at p into row. Returns the start of the next line or nullptr when the
+        // line is malformed.
+        char const *parseRow(char const *p, char const *end, char delimiter,
+                std::vector<ImportColumn> const &columns, size_t row, std::string &unquoted) {
+            for (size_t i = 0; i != columns.size(); ++i) {
+                auto const &column = columns[i];
+                uint8_t *pValue = column.pData + row * column.size;
+                DdsSize fields = componentCount(column.type);
+
+                for (DdsSize field = 0; field != fields; ++field) {
+                    char const *pBegin = p;
+                    char const *pEnd;
+                    if (p != end && *p == '"') {
+                        // "" inside a quoted field stands for one quote
+                        unquoted.clear();
+                        for (++p;;) {
+                            char const *pQuote = findByte(p, end, '"');
+                            if (pQuote == end) {
+                                return nullptr;
+                            }
+                            unquoted.append(p, pQuote);
+                            p = pQuote + 1;
+                            if (p == end || *p != '"') {
+                                break;
+                            }
+                            unquoted.push_back('"');
+                            ++p;
+                        }
+                        pBegin = unquoted.data();
+                        pEnd = pBegin + unquoted.size();
+                    } else {
+                        p = findAny(p, end, delimiter, '\n', '\r');
+                        pEnd = p;
+                    }
+
+                    if (!storeField(column.type, pBegin, pEnd, pValue + field * sizeof(float))) {
+                        return nullptr;
+                    }
+
+                    bool last = i + 1 == columns.size() && field + 1 == fields;
+                    if (!last) {
+                        if (p == end || *p != delimiter) {
+                            return nullptr;
+                        }
+                        ++p;
+                    }
+                }
+            }
+
+            if (p != end && *p == '\r') {
+                ++p;
+            }
+            if (p != end) {
+                if (*p != '\n') {
+                    return nullptr;
+                }
+                ++p;
+            }
+            return p;
+        }
+
+        // Splits the rows into chunks of about equal size ending after a line break, counts
+        // the rows of every chunk in parallel and then parses all chunks straight into their
+        // final position in the columns.
+        DdsResult importCsv(char const *begin, char const *end, DdsImportOptions const &options,
+                std::vector<DdsDataType> const &types, std::vector<size_t> const &fileColumns,
+                std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount) {
+            char delimiter = options.delimiter ? options.delimiter : ',';
+            for (uint32_t i = 0; i != options.skipRows && begin != end; ++i) {
+                begin = findByte(begin, end, '\n');
+                begin = begin == end ? end : begin + 1;
+            }
+
+            size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+            auto chunkSize = std::max<size_t>(static_cast<size_t>(end - begin) / (threadCount * 4),
+                    minChunkSize);
+            std::vector<char const *> bounds{begin};
+            while (static_cast<size_t>(end - bounds.back()) > chunkSize) {
+                char const *p = findByte(bounds.back() + chunkSize, end, '\n');
+                if (p == end || p + 1 == end) {
+                    break;
+                }
+                bounds.push_back(p + 1);
+            }
+            bounds.push_back(end);
+
+            size_t chunkCount = bounds.size() - 1;
+            std::vector<DdsSize> firstRows(chunkCount + 1);
+            parallelFor(chunkCount, [&](size_t i) {
+                char const *pBegin = bounds[i];
+                char const *pEnd = bounds[i + 1];
+                DdsSize rows = countByte(pBegin, pEnd, '\n');
+                // last line without a line break
+                if (pBegin != pEnd && pEnd[-1] != '\n') {
+                    ++rows;
+                }
+                firstRows[i + 1] = rows;
+            });
+            for (size_t i = 0; i != chunkCount; ++i) {
+                firstRows[i + 1] += firstRows[i];
+            }
+            rowCount = firstRows.back();
+
+            for (size_t i = 0; i != types.size(); ++i) {
+                columns[i].resize(rowCount * sizeOfType(types[i]));
+            }
+
+            std::vector<ImportColumn> targets;
+            for (size_t index : fileColumns) {
+                targets.push_back({types[index], columns[index].data(), sizeOfType(types[index])});
+            }
+
+            std::atomic<bool> malformed{false};
+            parallelFor(chunkCount, [&](size_t i) {
+                std::string unquoted;
+                char const *p = bounds[i];
+                DdsSize row = firstRows[i];
+                while (p && p != bounds[i + 1] && row != firstRows[i + 1]) {
+                    p = parseRow(p, bounds[i + 1], delimiter, targets, row++, unquoted);
+                }
+                // quoted line breaks make the counted rows differ from the parsed ones
+                if (p != bounds[i + 1] || row != firstRows[i + 1]) {
+                    malformed = true;
+                }
+            });
+            return malformed ? DDS_RESULT_INVALID_DATA : DDS_RESULT_SUCCESS;
+        }
+
+        // Values of the file columns one after another, each as rowCount values laid out like
+        // in memory
+        DdsResult importColumnar(uint8_t const *begin, uint8_t const *end,
+                std::vector<DdsDataType> const &types, std::vector<size_t> const &fileColumns,
+                std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount) {
+            DdsSize rowSize = 0;
+            for (size_t index : fileColumns) {
+                rowSize += sizeOfType(types[index]);
+            }
+
+            auto fileSize = static_cast<DdsSize>(end - begin);
+            if (rowSize == 0 || fileSize % rowSize != 0) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+            rowCount = fileSize / rowSize;
+
+            for (size_t i = 0; i != types.size(); ++i) {
+                columns[i].resize(rowCount * sizeOfType(types[i]));
+            }
+
+            struct Chunk {
+                size_t column;
+                DdsSize firstRow;
+                DdsSize rows;
+                uint8_t const *pSource;
+            };
+
+            std::vector<Chunk> chunks;
+            uint8_t const *pSource = begin;
+            for (size_t i = 0; i != fileColumns.size(); ++i) {
+                DdsSize size = sizeOfType(types[fileColumns[i]]);
+                DdsSize chunkRows = std::max<DdsSize>(16 * minChunkSize / size, 1);
+                for (DdsSize row = 0; row < rowCount; row += chunkRows) {
+                    chunks.push_back({i, row, std::min(chunkRows, rowCount - row),
+                            pSource + row * size});
+                }
+                pSource += rowCount * size;
+            }
+
+            parallelFor(chunks.size(), [&](size_t i) {
+                auto const &chunk = chunks[i];
+                size_t index = fileColumns[chunk.column];
+                DdsSize size = sizeOfType(types[index]);
+                uint8_t *pDst = columns[index].data() + chunk.firstRow * size;
+                std::memcpy(pDst, chunk.pSource, chunk.rows * size);
+
+                if (DdsSize capacity = stringCapacity(types[index])) {
+                    for (DdsSize row = 0; row != chunk.rows; ++row) {
+                        DdsSize length;
+                        std::memcpy(&length, pDst + row * size, sizeof(length));
+                        length = std::min(length, capacity);
+                        std::memcpy(pDst + row * size, &length, sizeof(length));
+                    }
+                }
+            });
+            return DDS_RESULT_SUCCESS;
+        }
+    }
+
+    DdsResult importFile(DdsImportFormat format, char const *path, DdsImportOptions const &options,
+            std::vector<DdsDataType> const &types, std::vector<size_t> const &fileColumns,
+            std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount) {
+        columns.assign(types.size(), {});
+        rowCount = 0;
+
+        // rows are parsed into fixed size slots, ddsImportArrow takes variable length strings
+        if (std::find(types.begin(), types.end(), DDS_STRING_TYPE) != types.end()) {
+            return DDS_RESULT_INVALID_TYPE;
+        }
+
+        struct stat info{};
+        if (::stat(path, &info) != 0) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        if (info.st_size == 0) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        // private pages are only read here, so they stay shared with the page cache
+        CowMapping file(path);
+        if (!file.isOpen()) {
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        switch (format) {
+            case DDS_IMPORT_CSV:
+                return importCsv(reinterpret_cast<char const *>(file.begin()),
+                        reinterpret_cast<char const *>(file.end()), options, types, fileColumns,
+                        columns, rowCount);
+            case DDS_IMPORT_COLUMNAR:
+                return importColumnar(file.begin(), file.end(), types, fileColumns, columns,
+                        rowCount);
+        }
+        return DDS_RESULT_INVALID_DATA;
+    }
+}
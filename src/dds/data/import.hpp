@@ -0,0 +1,13 @@
+#pragma once
+
+#include "dds/dds.h"
+#include <cstddef>
+#include <vector>
+
+namespace dds {
+    // Parses a file into one buffer per table column. fileColumns maps the columns of the file
+    // to indices in types, table columns missing from the file stay zeroed.
+    DdsResult importFile(DdsImportFormat format, char const *path, DdsImportOptions const &options,
+            std::vector<DdsDataType> const &types, std::vector<size_t> const &fileColumns,
+            std::vector<std::vector<uint8_t>> &columns, DdsSize &rowCount);
+}
@@ -1,31 +1,37 @@
-#include "instance.hpp"
+#include "helpers.hpp"
+#include "cow.hpp"
 #include <cista/serialization.h>
 
 namespace dds {
-    InstanceHelpers makeComponents(dds::InstanceData &data) {
-        InstanceHelpers components = {
-                makeComponent(data.tables),
-                makeComponent(data.columns),
-                makeComponent(data.aosTables),
-                IdMap{components.tables, data.tables.name},
-                MultiConnection{components.columns, data.columns.table, components.tables},
-                Connection{components.aosTables, data.aosTables.table, components.tables},
-        };
-        return components;
-    }
+    InstanceHelpers::InstanceHelpers(InstanceData &data) :
+            tables(makeComponent(data.tables)),
+            columns(makeComponent(data.columns)),
+            aosTables(makeComponent(data.aosTables)),
+            tableNameIndex(tables, data.tables.name),
+            tableColumns(columns, data.columns.table, tables, data.tables.name.size()),
+            tableAosData(aosTables, data.aosTables.table, tables, data.tables.name.size()) {}
 
     SerializeInfo makeSerializeInfo(DdsInstanceCreateFlags flags, const char *file) {
         SerializeInfo info;
         info.path = file;
 
         if (flags & DDS_INSTANCE_CREATE_MMAP_WRITE) {
-            info.mmap = cista::buf{cista::mmap{file, cista::mmap::protection::WRITE}};
+            // WRITE would truncate the file
+            info.mmap = cista::buf{cista::mmap{file, cista::mmap::protection::MODIFY}};
             dds::InstanceData *pData = dds::data::deserialize<dds::InstanceData>(*info.mmap);
             info.data = DataPtr(pData, [](dds::InstanceData *) {});
         } else if (flags & DDS_INSTANCE_CREATE_MMAP_READ) {
             info.mmap = cista::buf{cista::mmap{file, cista::mmap::protection::READ}};
             dds::InstanceData *pData = dds::data::deserialize<dds::InstanceData>(*info.mmap);
             info.data = DataPtr(pData, [](dds::InstanceData *) {});
+        } else if (auto cow = std::make_shared<CowMapping>(file);
+                !(flags & DDS_INSTANCE_CREATE_HEAP) && cow->isOpen()) {
+            // pointer fixups only dirty the pages of vector headers, column data stays shared
+            // until it is written or moved to the heap by growing
+            dds::InstanceData *pData = dds::data::deserialize<dds::InstanceData>(cow->begin(),
+                    cow->end());
+            info.cow = std::move(cow);
+            info.data = DataPtr(pData, [](dds::InstanceData *p) { p->~InstanceData(); });
         } else {
             cista::buf b{cista::mmap{file, cista::mmap::protection::READ}};
             dds::InstanceData *pData = dds::data::deserialize<dds::InstanceData>(b);
@@ -35,57 +41,4 @@ namespace dds {
 
         return info;
     }
-
-    std::pair<SerializeInfo, AllocatorData> makeAllocatorData(const char *file,
-            DdsAllocator allocator) {
-        AllocatorData allocatorData = {allocator, {}, {}};
-        using DataVec = std::vector<uint8_t, DataAllocator<uint8_t>>;
-
-        SerializeInfo info;
-        info.path = file;
-
-        cista::buf b{cista::mmap{file, cista::mmap::protection::READ}};
-        dds::InstanceData *pData = dds::data::deserialize<dds::InstanceData>(b);
-        for (auto const &tableData : pData->aosTables.data) {
-            DataVec vec(tableData.begin(), tableData.end(), DataAllocator<uint8_t>(allocator));
-            allocatorData.aosData.push_back(std::move(vec));
-        }
-        for (auto const &columnData : pData->columns.soaColumnData) {
-            DataVec vec(columnData.begin(), columnData.end(), DataAllocator<uint8_t>(allocator));
-            allocatorData.aosData.push_back(std::move(vec));
-        }
-
-        info.data = DataPtr(new dds::InstanceData(), [](dds::InstanceData *p) { delete p; });
-        auto &data = *info.data;
-        data.columns = {
-                pData->columns.name,
-                pData->columns.type,
-                pData->columns.table,
-                pData->columns.aosColumnOffset,
-        };
-        data.tables = pData->tables;
-        data.aosTables = {
-                pData->aosTables.table,
-                pData->aosTables.rowSize,
-        };
-        return {std::move(info), std::move(allocatorData)};
-    }
-
-    InstanceHelpers makeAllocatorComponents(dds::InstanceData &data,
-            dds::AllocatorData &allocator) {
-        InstanceHelpers components = {
-                makeComponent(data.tables),
-                Component{data.columns.name,
-                        data.columns.type,
-                        data.columns.table,
-                        data.columns.aosColumnOffset,
-                        allocator.soaData,
-                },
-                makeComponent(data.aosTables),
-                IdMap{components.tables, data.tables.name},
-                MultiConnection{components.columns, data.columns.table, components.tables},
-                Connection{components.aosTables, data.aosTables.table, components.tables},
-        };
-        return components;
-    }
 }
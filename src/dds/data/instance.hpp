@@ -5,6 +5,9 @@
 #include <cista/containers.h>
 #include <cista/mmap.h>
 #include <cista/targets/buf.h>
+#include <memory>
+#include <optional>
+#include <string>
 
 namespace std {
     template<>
@@ -30,46 +33,54 @@ namespace dds {
         data::vector<DdsSize> length{};
     };
 
+    // Characters of a DDS_STRING_TYPE column. Removed and overwritten values stay as garbage
+    // until the heap is compacted.
+    struct StringHeap {
+        data::vector<uint8_t> chars{};
+        DdsSize garbage{};
+    };
+
     struct ColumnData {
         data::vector<data::string> name{};
         data::vector<DdsDataType> type{};
         data::vector<DdsId> table{};
         data::vector<DdsSize> aosColumnOffset{};
+        data::vector<data::vector<uint8_t>> soaColumnData{}; // empty for columns of aos tables
+        data::vector<StringHeap> stringHeap{}; // empty for other types
     };
 
+    // the member named data hides the namespace alias, hence the qualified names
     struct AosTableData {
-        data::vector<DdsId> table{};
-        data::vector<DdsSize> rowSize{};
+        dds::data::vector<DdsId> table{};
+        dds::data::vector<dds::data::vector<uint8_t>> data{};
+        dds::data::vector<DdsSize> rowSize{};
     };
 
     struct InstanceData {
         TableData tables;
         ColumnData columns;
         AosTableData aosTables;
+        uint64_t walLsn{}; // last write-ahead log record contained in the snapshot
     };
 
-    struct SerializeTablesData {
-        data::vector<data::vector<uint8_t>> columnAosData;
-        data::vector<data::vector<uint8_t>> soaTableData;
-    };
+    // Makes bytes use memory it does not own, cista leaves such memory alone on destruction
+    inline void pointAt(data::vector<uint8_t> &bytes, uint8_t *pData, size_t size,
+            size_t capacity) {
+        bytes.el_ = pData;
+        bytes.used_size_ = static_cast<decltype(bytes.used_size_)>(size);
+        bytes.allocated_size_ = static_cast<decltype(bytes.allocated_size_)>(capacity);
+        bytes.self_allocated_ = false;
+    }
 
-    struct SerializeData {
-        InstanceData instanceData;
-        SerializeTablesData tablesData;
-    };
+    class CowMapping;
 
     using DataPtr = std::unique_ptr<dds::InstanceData, void (*)(dds::InstanceData *)>;
 
     struct SerializeInfo {
         std::string path;
         std::optional<cista::buf<cista::mmap>> mmap;
+        std::shared_ptr<CowMapping> cow{};
         DataPtr data{nullptr, [](dds::InstanceData *) {}};
     };
-    SerializeInfo loadSerializeData(DdsInstanceCreateFlags flags, const char *file);
-
-    struct AllocatorData {
-        std::vector<std::vector<uint8_t, DataAllocator<uint8_t>>> aosData;
-        std::vector<std::vector<uint8_t, DataAllocator<uint8_t>>> soaData;
-    };
-    AllocatorData loadAllocatorData(InstanceData &data, DdsAllocator allocator);
+    SerializeInfo makeSerializeInfo(DdsInstanceCreateFlags flags, const char *file);
 }
@@ -0,0 +1,194 @@
+#include "mapped.hpp"
+#include "stats.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace dds {
+    namespace {
+        constexpr size_t minCapacity = 64 * 1024;
+
+        size_t roundUp(size_t size, size_t alignment) {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        size_t growCapacity(size_t capacity, size_t required) {
+            return roundUp(std::max(required, capacity * 2), minCapacity);
+        }
+    }
+
+    MappedFile::MappedFile(std::string dir, std::string name, size_t minSize) :
+            path(dir + "/" + name), fileName(std::move(name)) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd == -1) {
+            return;
+        }
+
+        struct stat info{};
+        ::fstat(fd, &info);
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        size_t capacity = std::max(fileSize, roundUp(std::max(minSize, minCapacity), minCapacity));
+        if (capacity != fileSize && ::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            return;
+        }
+
+        void *p = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            pData = static_cast<uint8_t *>(p);
+            mappedSize = capacity;
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (pData) {
+            ::munmap(pData, mappedSize);
+        }
+        if (fd != -1) {
+            ::close(fd);
+        }
+        if (unlink) {
+            ::unlink(path.c_str());
+        }
+    }
+
+    bool MappedFile::grow(size_t capacity) {
+        if (::ftruncate(fd, static_cast<off_t>(capacity)) != 0) {
+            return false;
+        }
+
+        void *p = ::mremap(pData, mappedSize, capacity, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        pData = static_cast<uint8_t *>(p);
+        mappedSize = capacity;
+        return true;
+    }
+
+    bool MappedFile::sync(size_t size) {
+        size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t length = std::min(roundUp(size, pageSize), mappedSize);
+        return length == 0 || ::msync(pData, length, MS_SYNC) == 0;
+    }
+
+    DdsResult MappedStore::attach(data::vector<uint8_t> &bytes, std::string const &name,
+            size_t size) {
+        auto file = std::make_unique<MappedFile>(dir, name, size);
+        if (!file->isOpen()) {
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        pointAt(bytes, file->data(), size, file->capacity());
+        files.emplace(file->data(), std::move(file));
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult MappedStore::reserve(data::vector<uint8_t> &bytes, size_t size,
+            uint64_t &nextFile) {
+        auto iter = files.find(bytes.data());
+        if (iter == files.end()) {
+            std::string name = "seg-" + std::to_string(nextFile++);
+            auto file = std::make_unique<MappedFile>(dir, name, std::max(size, bytes.size()));
+            if (!file->isOpen()) {
+                return DDS_RESULT_IO_ERROR;
+            }
+
+            size_t used = bytes.size();
+            std::copy(bytes.begin(), bytes.end(), file->data());
+            bytes.reset();
+            pointAt(bytes, file->data(), used, file->capacity());
+            files.emplace(file->data(), std::move(file));
+            return DDS_RESULT_SUCCESS;
+        }
+
+        MappedFile *pFile = iter->second.get();
+        if (size <= pFile->capacity()) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        auto node = files.extract(iter);
+        bool grown = pFile->grow(growCapacity(pFile->capacity(), size));
+        node.key() = pFile->data();
+        files.insert(std::move(node));
+        if (!grown) {
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        pointAt(bytes, pFile->data(), bytes.size(), pFile->capacity());
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult MappedStore::checkpoint(InstanceData &data, SegmentState &state) {
+        DDS_STAT_SCOPE(Stat::MappedCheckpoint);
+        auto regions = segmentRegions(data);
+        std::vector<std::vector<std::string>> names(regions.size());
+        std::vector<std::vector<BlockChecksums>> checksums(regions.size());
+        std::unordered_set<MappedFile const *> referenced;
+
+        for (size_t table = 0; table != regions.size(); ++table) {
+            if (!state.loaded[table]) {
+                names[table] = state.files[table];
+                checksums[table] = state.checksums[table];
+                continue;
+            }
+
+            for (auto pBytes : regions[table]) {
+                DdsResult result = reserve(*pBytes, pBytes->size(), state.nextFile);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+
+                MappedFile *pFile = files.at(pBytes->data()).get();
+                if (!pFile->sync(pBytes->size())) {
+                    return DDS_RESULT_IO_ERROR;
+                }
+                names[table].push_back(pFile->name());
+                referenced.insert(pFile);
+            }
+
+            // clean tables that still live in the same files keep their checksums
+            if (!state.dirty[table] && names[table] == state.files[table]) {
+                checksums[table] = state.checksums[table];
+                continue;
+            }
+            for (auto pBytes : regions[table]) {
+                checksums[table].push_back(blockChecksums(pBytes->data(), pBytes->size()));
+            }
+        }
+
+        // segment files created since the last checkpoint must be reachable before the
+        // manifest names them
+        DdsResult result = syncDirectory(dir);
+        if (result == DDS_RESULT_SUCCESS) {
+            result = writeManifest(data, dir, state, names, checksums, state.nextFile);
+        }
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        // writeManifest synced the directory after its rename, from here on no manifest a crash
+        // can bring back names the files unlinked below
+        state.files = std::move(names);
+        state.checksums = std::move(checksums);
+        std::fill(state.dirty.begin(), state.dirty.end(), 0);
+
+        // tables removed before they were ever loaded
+        for (auto const &name : state.obsolete) {
+            ::unlink((dir + "/" + name).c_str());
+        }
+        state.obsolete.clear();
+
+        // files of removed columns and tables, or of vectors cista copied onto the heap
+        for (auto iter = files.begin(); iter != files.end();) {
+            if (referenced.count(iter->second.get())) {
+                ++iter;
+            } else {
+                iter->second->unlinkOnClose();
+                iter = files.erase(iter);
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+}
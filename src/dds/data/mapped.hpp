@@ -0,0 +1,77 @@
+#pragma once
+
+#include "instance.hpp"
+#include "segment.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace dds {
+    // Segment file mapped shared for reading and writing. Growing extends the sparse file and
+    // remaps it, so the data may move.
+    class MappedFile {
+    public:
+        MappedFile(std::string dir, std::string name, size_t minCapacity);
+
+        MappedFile(MappedFile const &) = delete;
+
+        MappedFile &operator=(MappedFile const &) = delete;
+
+        ~MappedFile();
+
+        bool isOpen() const {
+            return pData != nullptr;
+        }
+
+        uint8_t *data() const {
+            return pData;
+        }
+
+        size_t capacity() const {
+            return mappedSize;
+        }
+
+        std::string const &name() const {
+            return fileName;
+        }
+
+        bool grow(size_t capacity);
+
+        // flushes dirty pages of the first size bytes to the file
+        bool sync(size_t size);
+
+        void unlinkOnClose() {
+            unlink = true;
+        }
+
+    private:
+        std::string path;
+        std::string fileName;
+        int fd = -1;
+        uint8_t *pData = nullptr;
+        size_t mappedSize = 0;
+        bool unlink = false;
+    };
+
+    // Live storage of a segmented instance opened with DDS_INSTANCE_CREATE_MMAP_WRITE. Byte
+    // vectors of columns and aos tables point into mapped segment files instead of owning heap
+    // memory. Inserts reserve through the store first, so cista never reallocates them.
+    class MappedStore {
+    public:
+        explicit MappedStore(std::string dir) : dir(std::move(dir)) {}
+
+        DdsResult attach(data::vector<uint8_t> &bytes, std::string const &name, size_t size);
+
+        // Makes room for size bytes. A vector still on the heap, like the one of a column
+        // created after open, is moved into a new segment file first.
+        DdsResult reserve(data::vector<uint8_t> &bytes, size_t size, uint64_t &nextFile);
+
+        // Flushes every mapped vector, writes the manifest and deletes segment files of
+        // removed columns and tables
+        DdsResult checkpoint(InstanceData &data, SegmentState &state);
+
+    private:
+        std::string dir;
+        std::unordered_map<uint8_t const *, std::unique_ptr<MappedFile>> files;
+    };
+}
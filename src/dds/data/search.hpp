@@ -1,29 +1,43 @@
 #pragma once
 
-#include "instance.hpp"
-#include "components.hpp"
+#include "helpers.hpp"
+#include "strings.hpp"
+#include "table.hpp"
 #include "dds/helpers/IdMap.hpp"
 #include "dds/cpp/DataString.hpp"
 
 namespace dds {
-    struct SearchHelpers {
-        IdMap<data::string> tableNameIndex;
-        MultiConnection tableColumns;
-        Connection tableAosData;
-    };
-
-    SearchHelpers makeSearchHelpers(InstanceData &data, Components &components);
-
     struct IdMaps {
         std::unordered_map<DdsId, IdMap<dds::String16>> strings16;
         std::unordered_map<DdsId, IdMap<dds::String64>> strings64;
         std::unordered_map<DdsId, IdMap<dds::String256>> strings256;
+        std::unordered_map<DdsId, IdMap<std::string>> strings;
         std::unordered_map<DdsId, IdMap<float>> floats;
         std::unordered_map<DdsId, IdMap<double>> doubles;
         std::unordered_map<DdsId, IdMap<uint64_t>> uints64;
         std::unordered_map<DdsId, IdMap<int64_t>> ints64;
         std::unordered_map<DdsId, IdMap<uint32_t>> uints32;
         std::unordered_map<DdsId, IdMap<int32_t>> ints32;
+
+        // f(column, idMap) for the maps of every type
+        template<typename FnT>
+        void forEach(FnT &&f) const {
+            auto each = [&f](auto const &maps) {
+                for (auto const &[column, idMap] : maps) {
+                    f(column, idMap);
+                }
+            };
+            each(strings16);
+            each(strings64);
+            each(strings256);
+            each(strings);
+            each(floats);
+            each(doubles);
+            each(uints64);
+            each(ints64);
+            each(uints32);
+            each(ints32);
+        }
     };
 
     template<typename FnT>
@@ -35,6 +49,9 @@ namespace dds {
                 return f(maps.strings64, *reinterpret_cast<dds::String64 const *>(pData));
             case DDS_STRING256_TYPE:
                 return f(maps.strings256, *reinterpret_cast<dds::String256 const *>(pData));
+            case DDS_STRING_TYPE:
+                return f(maps.strings,
+                        std::string(stringValue(1, static_cast<uint8_t const *>(pData), 0)));
             case DDS_FLOAT_TYPE:
                 return f(maps.floats, *reinterpret_cast<float const *>(pData));
             case DDS_DOUBLE_TYPE:
@@ -57,22 +74,37 @@ namespace dds {
         }
     }
 
-    template<typename T, typename FnT>
-    DdsResult getRange(InstanceData &data, SearchHelpers &components, DdsId column, FnT &&f) {
-        DdsId table = data.columns.table[column];
-        if (auto aosIndex = components.tableAosData[table]) {
-            auto &bytes = data.aosTables.data[*aosIndex];
-            auto offset = data.columns.aosColumnOffset[column];
-            auto stride = data.aosTables.rowSize[*aosIndex];
-            dds::DataRange<T> range{bytes, offset, stride};
-            return f(range);
-        } else {
-            auto &bytes = data.columns.soaColumnData[column];
-            auto beg = reinterpret_cast<T *>(bytes.begin());
-            auto end = beg + bytes.size() / sizeof(T);
-            dds::Range<T> range{beg, end};
-            return f(range);
+    // Values of a column read from the table on every access, so inserts and removes that move
+    // the column data never leave it behind. Index maps and connections keep it for their
+    // whole life, which makes the caller give it a stable home.
+    template<typename T>
+    class ColumnValues {
+    public:
+        using value_type = T;
+
+        ColumnValues(InstanceHelpers &components, InstanceData &data, DdsId column)
+                : pComponents(&components), pData(&data), column(column) {}
+
+        size_t size() const {
+            return rowCount(*pComponents, *pData, pData->columns.table[column]);
         }
+
+        T &operator[](size_t position) const {
+            return *reinterpret_cast<T *>(cellData(*pComponents, *pData, column, position));
+        }
+
+        T &back() const {
+            return (*this)[size() - 1];
+        }
+
+    private:
+        InstanceHelpers *pComponents;
+        InstanceData *pData;
+        DdsId column;
+    };
+
+    template<typename T, typename FnT>
+    DdsResult getRange(InstanceData &data, InstanceHelpers &components, DdsId column, FnT &&f) {
+        return f(ColumnValues<T>(components, data, column));
     }
 }
-
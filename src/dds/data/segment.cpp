@@ -0,0 +1,472 @@
+#include "segment.hpp"
+#include "mapped.hpp"
+#include "stats.hpp"
+#include "strings.hpp"
+#include "dds/helpers/checksum.hpp"
+#include "dds/helpers/generic.hpp"
+#include "dds/helpers/parallel.hpp"
+#include <atomic>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace dds {
+    namespace {
+        // files are written in chunks of this size so a single large column spreads over threads
+        constexpr size_t writeChunkSize = 64 * checksumBlockSize;
+
+        size_t blockCount(size_t size) {
+            return (size + checksumBlockSize - 1) / checksumBlockSize;
+        }
+
+        bool pwriteAll(int fd, uint8_t const *pData, size_t size, size_t offset) {
+            while (size != 0) {
+                ssize_t written = ::pwrite(fd, pData, size, static_cast<off_t>(offset));
+                if (written < 0) {
+                    return false;
+                }
+                pData += written;
+                offset += static_cast<size_t>(written);
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+    }
+
+    void SegmentState::onTablesInsert(size_t count) {
+        dirty.resize(dirty.size() + count, 1);
+        loaded.resize(loaded.size() + count, 1);
+        files.resize(files.size() + count);
+        sizes.resize(sizes.size() + count);
+        checksums.resize(checksums.size() + count);
+    }
+
+    void SegmentState::onTableRemove(size_t table) {
+        obsolete.insert(obsolete.end(), files[table].begin(), files[table].end());
+        unstableRemove(files, table);
+        unstableRemove(sizes, table);
+        unstableRemove(checksums, table);
+        unstableRemove(dirty, table);
+        unstableRemove(loaded, table);
+    }
+
+    std::string manifestPath(std::string const &dir) {
+        return dir + "/manifest";
+    }
+
+    SegmentRegions segmentRegions(InstanceData &data) {
+        SegmentRegions result(data.tables.name.size());
+        std::vector<bool> isAos(data.tables.name.size());
+        for (size_t aosId = 0; aosId != data.aosTables.table.size(); ++aosId) {
+            DdsId table = data.aosTables.table[aosId];
+            result[table].push_back(&data.aosTables.data[aosId]);
+            isAos[table] = true;
+        }
+        for (size_t column = 0; column != data.columns.table.size(); ++column) {
+            DdsId table = data.columns.table[column];
+            if (!isAos[table]) {
+                result[table].push_back(&data.columns.soaColumnData[column]);
+            }
+        }
+        for (size_t column = 0; column != data.columns.table.size(); ++column) {
+            if (data.columns.type[column] == DDS_STRING_TYPE) {
+                DdsId table = data.columns.table[column];
+                result[table].push_back(&data.columns.stringHeap[column].chars);
+            }
+        }
+        return result;
+    }
+
+    std::vector<data::vector<uint8_t> *> tableRegions(InstanceData &data, DdsId table) {
+        std::vector<data::vector<uint8_t> *> result;
+        for (size_t aosId = 0; aosId != data.aosTables.table.size(); ++aosId) {
+            if (data.aosTables.table[aosId] == table) {
+                result.push_back(&data.aosTables.data[aosId]);
+            }
+        }
+        if (result.empty()) {
+            for (size_t column = 0; column != data.columns.table.size(); ++column) {
+                if (data.columns.table[column] == table) {
+                    result.push_back(&data.columns.soaColumnData[column]);
+                }
+            }
+        }
+        for (size_t column = 0; column != data.columns.table.size(); ++column) {
+            if (data.columns.table[column] == table &&
+                    data.columns.type[column] == DDS_STRING_TYPE) {
+                result.push_back(&data.columns.stringHeap[column].chars);
+            }
+        }
+        return result;
+    }
+
+    InstanceData makeCatalog(InstanceData const &data) {
+        InstanceData catalog;
+        catalog.tables = data.tables;
+        catalog.columns.name = data.columns.name;
+        catalog.columns.type = data.columns.type;
+        catalog.columns.table = data.columns.table;
+        catalog.columns.aosColumnOffset = data.columns.aosColumnOffset;
+        // heap characters live in the segments of their tables
+        catalog.columns.stringHeap.resize(data.columns.stringHeap.size());
+        for (size_t column = 0; column != data.columns.stringHeap.size(); ++column) {
+            catalog.columns.stringHeap[column].garbage = data.columns.stringHeap[column].garbage;
+        }
+        catalog.columns.soaColumnData.resize(data.columns.soaColumnData.size());
+        catalog.aosTables.table = data.aosTables.table;
+        catalog.aosTables.rowSize = data.aosTables.rowSize;
+        catalog.aosTables.data.resize(data.aosTables.data.size());
+        catalog.walLsn = data.walLsn;
+        return catalog;
+    }
+
+    DdsResult loadSegmented(char const *dir, SerializeInfo &info, SegmentState &state,
+            MappedStore *pStore, bool lazy) {
+        info.path = dir;
+        info.data = DataPtr(new InstanceData(), [](InstanceData *p) { delete p; });
+
+        std::string path = manifestPath(dir);
+        if (!fs::exists(path)) {
+            std::error_code error;
+            fs::create_directories(dir, error);
+            return error ? DDS_RESULT_IO_ERROR : DDS_RESULT_SUCCESS;
+        }
+
+        {
+            cista::buf b{cista::mmap{path.c_str(), cista::mmap::protection::READ}};
+            Manifest *pManifest = data::deserialize<Manifest>(b);
+            *info.data = pManifest->catalog;
+
+            for (auto const &files : pManifest->segments.tableFiles) {
+                auto &tableFiles = state.files.emplace_back();
+                for (auto const &file : files) {
+                    tableFiles.emplace_back(file.begin(), file.size());
+                }
+            }
+            for (auto const &tableSizes : pManifest->segments.tableSizes) {
+                state.sizes.emplace_back(tableSizes.begin(), tableSizes.end());
+            }
+            for (auto const &tableChecksums : pManifest->segments.tableChecksums) {
+                auto &checksums = state.checksums.emplace_back();
+                for (auto const &fileChecksums : tableChecksums) {
+                    checksums.emplace_back(fileChecksums.begin(), fileChecksums.end());
+                }
+            }
+            state.nextFile = pManifest->segments.nextFile;
+        }
+        state.dirty.assign(state.files.size(), 0);
+        state.loaded.assign(state.files.size(), 0);
+
+        if (lazy) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        for (size_t table = 0; table != state.files.size(); ++table) {
+            DdsResult result = loadTable(*info.data, dir, state, pStore, table);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult loadTable(InstanceData &data, std::string const &dir, SegmentState &state,
+            MappedStore *pStore, DdsId table) {
+        if (state.loaded[table]) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        DDS_STAT_SCOPE(Stat::SegmentLoad);
+
+        auto regions = tableRegions(data, table);
+        if (regions.size() != state.files[table].size()) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        if (pStore) {
+            for (size_t i = 0; i != regions.size(); ++i) {
+                DdsResult result = pStore->attach(*regions[i], state.files[table][i],
+                        state.sizes[table][i]);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+            }
+            DdsResult result = extendMappedHeaps(data, table);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        } else {
+            std::atomic<bool> failed{false};
+            parallelFor(regions.size(), [&](size_t i) {
+                DdsResult result = readFile(dir + "/" + state.files[table][i],
+                        state.sizes[table][i], *regions[i]);
+                if (result != DDS_RESULT_SUCCESS) {
+                    failed = true;
+                }
+            });
+            if (failed) {
+                return DDS_RESULT_IO_ERROR;
+            }
+        }
+
+        // Mapped segments are written in place, so after a session that ended without a
+        // checkpoint they no longer match the manifest. Only copies read into memory are checked,
+        // mapped tables get their checksums computed again by the next checkpoint.
+        if (!pStore) {
+            DdsResult result = verifyBlocks(regions, state.checksums[table]);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        } else {
+            state.dirty[table] = 1;
+        }
+
+        state.loaded[table] = 1;
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult adviseTable(InstanceData &data, std::string const &dir, SegmentState &state,
+            DdsId table, DdsAccessHint hint) {
+        if (!state.loaded[table]) {
+            int advice = hint == DDS_ACCESS_HINT_RANDOM ? POSIX_FADV_RANDOM : POSIX_FADV_WILLNEED;
+            for (auto const &file : state.files[table]) {
+                int fd = ::open((dir + "/" + file).c_str(), O_RDONLY);
+                if (fd == -1) {
+                    return DDS_RESULT_IO_ERROR;
+                }
+                if (hint == DDS_ACCESS_HINT_SEQUENTIAL) {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                }
+                ::posix_fadvise(fd, 0, 0, advice);
+                ::close(fd);
+            }
+            return DDS_RESULT_SUCCESS;
+        }
+
+        int advice = MADV_WILLNEED;
+        if (hint == DDS_ACCESS_HINT_SEQUENTIAL) {
+            advice = MADV_SEQUENTIAL;
+        } else if (hint == DDS_ACCESS_HINT_RANDOM) {
+            advice = MADV_RANDOM;
+        }
+
+        auto pageSize = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+        for (auto pBytes : tableRegions(data, table)) {
+            if (pBytes->empty()) {
+                continue;
+            }
+            // madvise wants a page aligned start
+            auto beg = reinterpret_cast<uintptr_t>(pBytes->data()) / pageSize * pageSize;
+            auto end = reinterpret_cast<uintptr_t>(pBytes->data() + pBytes->size());
+            ::madvise(reinterpret_cast<void *>(beg), end - beg, advice);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult writeCheckpoint(InstanceData &data, std::string const &dir, SegmentState &state,
+            bool full) {
+        auto regions = segmentRegions(data);
+
+        // state is only updated once the new manifest is in place
+        auto files = state.files;
+        auto checksums = state.checksums;
+        uint64_t nextFile = state.nextFile;
+        std::vector<std::string> replaced;
+
+        std::vector<FileWrite> writes;
+        std::vector<DdsId> writeTables;
+        for (size_t table = 0; table != files.size(); ++table) {
+            // segments of a table that was never loaded are still current
+            if (!state.loaded[table] || (!full && !state.dirty[table])) {
+                continue;
+            }
+
+            replaced.insert(replaced.end(), files[table].begin(), files[table].end());
+            files[table].clear();
+            checksums[table].clear();
+            for (auto pBytes : regions[table]) {
+                std::string name = "seg-" + std::to_string(nextFile++);
+                files[table].push_back(name);
+                writes.push_back({dir + "/" + name, pBytes->data(), pBytes->size(), {}});
+                writeTables.push_back(table);
+            }
+        }
+
+        // the manifest must never name a segment whose directory entry is lost in a crash
+        DdsResult result = writeFiles(writes);
+        if (result == DDS_RESULT_SUCCESS) {
+            result = syncDirectory(dir);
+        }
+        if (result != DDS_RESULT_SUCCESS) {
+            for (auto const &write : writes) {
+                std::error_code error;
+                fs::remove(write.path, error);
+            }
+            return result;
+        }
+
+        for (size_t i = 0; i != writes.size(); ++i) {
+            checksums[writeTables[i]].push_back(std::move(writes[i].checksums));
+        }
+
+        result = writeManifest(data, dir, state, files, checksums, nextFile);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        state.files = std::move(files);
+        state.checksums = std::move(checksums);
+        state.nextFile = nextFile;
+        std::fill(state.dirty.begin(), state.dirty.end(), 0);
+
+        // writeManifest synced the directory after its rename, so a crash never brings back the
+        // old manifest once the segments it names are gone
+        replaced.insert(replaced.end(), state.obsolete.begin(), state.obsolete.end());
+        state.obsolete.clear();
+        for (auto const &name : replaced) {
+            std::error_code error;
+            fs::remove(dir + "/" + name, error);
+        }
+
+        return DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult writeManifest(InstanceData &data, std::string const &dir, SegmentState const &state,
+            std::vector<std::vector<std::string>> const &files,
+            std::vector<std::vector<BlockChecksums>> const &checksums, uint64_t nextFile) {
+        auto regions = segmentRegions(data);
+
+        Manifest manifest{makeCatalog(data), {}};
+        for (size_t table = 0; table != files.size(); ++table) {
+            auto &names = manifest.segments.tableFiles.emplace_back();
+            auto &sizes = manifest.segments.tableSizes.emplace_back();
+            auto &tableChecksums = manifest.segments.tableChecksums.emplace_back();
+            for (size_t i = 0; i != files[table].size(); ++i) {
+                names.emplace_back(files[table][i].c_str());
+                sizes.push_back(state.loaded[table] ? regions[table][i]->size()
+                                                    : state.sizes[table][i]);
+                tableChecksums.emplace_back(checksums[table][i].begin(), checksums[table][i].end());
+            }
+        }
+        manifest.segments.nextFile = nextFile;
+
+        return serializeAtomic(manifestPath(dir), manifest);
+    }
+
+    DdsResult writeFiles(std::vector<FileWrite> &writes) {
+        DDS_STAT_SCOPE(Stat::SegmentWrite);
+        struct Chunk {
+            size_t file;
+            size_t offset;
+        };
+
+        std::vector<int> fds(writes.size(), -1);
+        std::vector<Chunk> chunks;
+        std::atomic<bool> failed{false};
+        for (size_t i = 0; i != writes.size(); ++i) {
+            auto &write = writes[i];
+            fds[i] = ::open(write.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            // sized up front so chunks can be written in any order
+            if (fds[i] == -1 || ::ftruncate(fds[i], static_cast<off_t>(write.size)) != 0) {
+                failed = true;
+            }
+            write.checksums.assign(blockCount(write.size), 0);
+            for (size_t offset = 0; offset < write.size; offset += writeChunkSize) {
+                chunks.push_back({i, offset});
+            }
+        }
+
+        if (!failed) {
+            parallelFor(chunks.size(), [&](size_t i) {
+                auto &write = writes[chunks[i].file];
+                size_t offset = chunks[i].offset;
+                size_t size = std::min(writeChunkSize, write.size - offset);
+                if (!pwriteAll(fds[chunks[i].file], write.pData + offset, size, offset)) {
+                    failed = true;
+                }
+                for (size_t block = 0; block < size; block += checksumBlockSize) {
+                    write.checksums[(offset + block) / checksumBlockSize] = crc32(
+                            write.pData + offset + block, std::min(checksumBlockSize, size - block));
+                }
+            });
+        }
+
+        if (!failed) {
+            parallelFor(fds.size(), [&](size_t i) {
+                if (::fdatasync(fds[i]) != 0) {
+                    failed = true;
+                }
+            });
+        }
+
+        for (int fd : fds) {
+            if (fd != -1) {
+                ::close(fd);
+            }
+        }
+        return failed ? DDS_RESULT_IO_ERROR : DDS_RESULT_SUCCESS;
+    }
+
+    DdsResult syncDirectory(std::string const &dir) {
+        int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd == -1) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced ? DDS_RESULT_SUCCESS : DDS_RESULT_IO_ERROR;
+    }
+
+    DdsResult readFile(std::string const &path, size_t size, data::vector<uint8_t> &bytes) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        bytes.resize(size);
+        bool ok = ::pread(fd, bytes.data(), size, 0) == static_cast<ssize_t>(size);
+        ::close(fd);
+        return ok ? DDS_RESULT_SUCCESS : DDS_RESULT_IO_ERROR;
+    }
+
+    BlockChecksums blockChecksums(uint8_t const *pData, size_t size) {
+        BlockChecksums result(blockCount(size));
+        parallelFor(result.size(), [&](size_t block) {
+            size_t offset = block * checksumBlockSize;
+            result[block] = crc32(pData + offset, std::min(checksumBlockSize, size - offset));
+        });
+        return result;
+    }
+
+    DdsResult verifyBlocks(std::vector<data::vector<uint8_t> *> const &regions,
+            std::vector<BlockChecksums> const &checksums) {
+        if (checksums.size() != regions.size()) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        // blocks of all regions form one work list, so one large column still spreads out
+        std::vector<std::pair<size_t, size_t>> blocks;
+        for (size_t i = 0; i != regions.size(); ++i) {
+            if (checksums[i].size() != blockCount(regions[i]->size())) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+            for (size_t block = 0; block != checksums[i].size(); ++block) {
+                blocks.emplace_back(i, block);
+            }
+        }
+
+        std::atomic<bool> corrupted{false};
+        parallelFor(blocks.size(), [&](size_t i) {
+            auto [region, block] = blocks[i];
+            auto const &bytes = *regions[region];
+            size_t offset = block * checksumBlockSize;
+            size_t size = std::min(checksumBlockSize, bytes.size() - offset);
+            if (crc32(bytes.data() + offset, size) != checksums[region][block]) {
+                corrupted = true;
+            }
+        });
+        return corrupted ? DDS_RESULT_INVALID_DATA : DDS_RESULT_SUCCESS;
+    }
+}
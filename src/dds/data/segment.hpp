@@ -0,0 +1,128 @@
+#pragma once
+
+#include "instance.hpp"
+#include <cista/serialization.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace dds {
+    struct SegmentData {
+        // per table: one file for an aos table, one file per column in id order otherwise
+        data::vector<data::vector<data::string>> tableFiles{};
+        data::vector<data::vector<uint64_t>> tableSizes{};
+        // crc32 of every checksumBlockSize block of every file
+        data::vector<data::vector<data::vector<uint32_t>>> tableChecksums{};
+        uint64_t nextFile{};
+    };
+
+    // Catalog of a segmented instance directory. Column and aos table data and the characters of
+    // string heaps are empty here and live in the segment files.
+    struct Manifest {
+        InstanceData catalog;
+        SegmentData segments;
+    };
+
+    using BlockChecksums = std::vector<uint32_t>;
+
+    class SegmentState {
+    public:
+        void markDirty(DdsId table) {
+            dirty[table] = 1;
+        }
+
+        void onTablesInsert(size_t count);
+
+        void onTableRemove(size_t table);
+
+        std::vector<uint8_t> dirty;
+        std::vector<uint8_t> loaded;
+        std::vector<std::vector<std::string>> files;
+        std::vector<std::vector<uint64_t>> sizes; // from the manifest, used while not loaded
+        std::vector<std::vector<BlockChecksums>> checksums;
+        std::vector<std::string> obsolete;
+        uint64_t nextFile = 0;
+    };
+
+    class MappedStore;
+
+    using SegmentRegions = std::vector<std::vector<data::vector<uint8_t> *>>;
+
+    std::string manifestPath(std::string const &dir);
+
+    // Byte vectors stored in the segment files of every table: the aos table data or the
+    // columns in ascending id order, then the heaps of its string columns in ascending id order
+    SegmentRegions segmentRegions(InstanceData &data);
+
+    std::vector<data::vector<uint8_t> *> tableRegions(InstanceData &data, DdsId table);
+
+    InstanceData makeCatalog(InstanceData const &data);
+
+    // Reads the manifest and, unless lazy is set, the segments of every table
+    DdsResult loadSegmented(char const *dir, SerializeInfo &info, SegmentState &state,
+            MappedStore *pStore, bool lazy);
+
+    // Reads the segments of a table into heap memory or, when pStore is set, maps them as live
+    // storage. Block checksums are checked for the copies read into memory only. Does nothing
+    // for a table that is already loaded.
+    DdsResult loadTable(InstanceData &data, std::string const &dir, SegmentState &state,
+            MappedStore *pStore, DdsId table);
+
+    // madvise for a loaded table, readahead of its segment files for one that is not
+    DdsResult adviseTable(InstanceData &data, std::string const &dir, SegmentState &state,
+            DdsId table, DdsAccessHint hint);
+
+    DdsResult writeManifest(InstanceData &data, std::string const &dir, SegmentState const &state,
+            std::vector<std::vector<std::string>> const &files,
+            std::vector<std::vector<BlockChecksums>> const &checksums, uint64_t nextFile);
+
+    // Writes segments of dirty tables (all tables when full is set), then switches the
+    // manifest with a rename and deletes segments that are no longer referenced
+    DdsResult writeCheckpoint(InstanceData &data, std::string const &dir, SegmentState &state,
+            bool full);
+
+    struct FileWrite {
+        std::string path;
+        uint8_t const *pData;
+        size_t size;
+        BlockChecksums checksums; // filled by writeFiles
+    };
+
+    // Writes and syncs all files, splitting large ones into chunks written with pwrite on
+    // separate threads. Block checksums are computed while the data is hot.
+    DdsResult writeFiles(std::vector<FileWrite> &writes);
+
+    // The first size bytes of the file, segments written by a MappedStore have room to grow
+    // behind them
+    DdsResult readFile(std::string const &path, size_t size, data::vector<uint8_t> &bytes);
+
+    // Makes renames and unlinks in the directory durable, a synced file may otherwise still be
+    // reached by its old name after a crash
+    DdsResult syncDirectory(std::string const &dir);
+
+    BlockChecksums blockChecksums(uint8_t const *pData, size_t size);
+
+    // Checks every block of the regions against the manifest in parallel
+    DdsResult verifyBlocks(std::vector<data::vector<uint8_t> *> const &regions,
+            std::vector<BlockChecksums> const &checksums);
+
+    // Serializes into a temporary file and renames it over path, so readers and crashes only
+    // ever see the old or the new content
+    template<typename T>
+    DdsResult serializeAtomic(std::string const &path, T const &value) {
+        std::string tmpPath = path + ".tmp";
+        {
+            cista::buf b{cista::mmap{tmpPath.c_str(), cista::mmap::protection::WRITE}};
+            cista::serialize(b, value);
+            b.buf_.sync();
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tmpPath, path, error);
+        if (error) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        return syncDirectory(dir.empty() ? "." : dir);
+    }
+}
@@ -0,0 +1,41 @@
+#include "snapshot.hpp"
+#include "segment.hpp"
+
+namespace dds {
+    SnapshotJob::SnapshotJob(std::string path, std::unique_ptr<InstanceData> pData,
+            std::function<DdsResult()> onDone) {
+        writer = std::thread([this, path = std::move(path), pData = std::move(pData),
+                onDone = std::move(onDone)] {
+            // the rename is synced before onDone truncates the log
+            DdsResult value = serializeAtomic(path, *pData);
+            if (value == DDS_RESULT_SUCCESS && onDone) {
+                value = onDone();
+            }
+            finish(value);
+        });
+    }
+
+    SnapshotJob::~SnapshotJob() {
+        if (writer.joinable()) {
+            writer.join();
+        }
+    }
+
+    DdsResult SnapshotJob::poll() {
+        std::lock_guard lock(mutex);
+        return done ? result : DDS_RESULT_IN_PROGRESS;
+    }
+
+    DdsResult SnapshotJob::wait() {
+        std::unique_lock lock(mutex);
+        finished.wait(lock, [this] { return done; });
+        return result;
+    }
+
+    void SnapshotJob::finish(DdsResult value) {
+        std::lock_guard lock(mutex);
+        result = value;
+        done = true;
+        finished.notify_all();
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "instance.hpp"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dds {
+    // Serializes a frozen copy of the instance data to path from a background thread, through a
+    // temporary file renamed over it. If it succeeded, onDone runs on that thread.
+    class SnapshotJob {
+    public:
+        SnapshotJob(std::string path, std::unique_ptr<InstanceData> pData,
+                std::function<DdsResult()> onDone);
+
+        SnapshotJob(SnapshotJob const &) = delete;
+
+        SnapshotJob &operator=(SnapshotJob const &) = delete;
+
+        ~SnapshotJob();
+
+        // DDS_RESULT_IN_PROGRESS until the snapshot is complete
+        DdsResult poll();
+
+        DdsResult wait();
+
+    private:
+        void finish(DdsResult value);
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        DdsResult result = DDS_RESULT_IN_PROGRESS;
+        std::thread writer;
+    };
+}
@@ -0,0 +1,301 @@
+#include "sort.hpp"
+#include "column.hpp"
+#include "strings.hpp"
+#include "table.hpp"
+#include "type.hpp"
+#include "dds/helpers/parallel.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <thread>
+
+namespace dds {
+    namespace {
+        constexpr size_t minChunkRows = 64 * 1024;
+
+        struct KeyColumn {
+            uint8_t const *pData;
+            DdsSize stride;
+            DdsDataType type;
+            StringHeap const *pHeap;
+        };
+
+        bool isRadixType(DdsDataType type) {
+            switch (type) {
+                case DDS_INT32_TYPE:
+                case DDS_UINT32_TYPE:
+                case DDS_INT64_TYPE:
+                case DDS_UINT64_TYPE:
+                case DDS_FLOAT_TYPE:
+                case DDS_DOUBLE_TYPE:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        size_t chunkCount(size_t rows) {
+            size_t threads = std::max(1u, std::thread::hardware_concurrency());
+            return std::max<size_t>(1, std::min(threads, rows / minChunkRows));
+        }
+
+        template<typename T>
+        T load(uint8_t const *pCell) {
+            T value;
+            std::memcpy(&value, pCell, sizeof(T));
+            return value;
+        }
+
+        // unsigned key ordered like the value
+        uint64_t radixKey(DdsDataType type, uint8_t const *pCell) {
+            switch (type) {
+                case DDS_INT32_TYPE:
+                    return load<uint32_t>(pCell) ^ 0x80000000u;
+                case DDS_UINT32_TYPE:
+                    return load<uint32_t>(pCell);
+                case DDS_INT64_TYPE:
+                    return load<uint64_t>(pCell) ^ 0x8000000000000000u;
+                case DDS_UINT64_TYPE:
+                    return load<uint64_t>(pCell);
+                case DDS_FLOAT_TYPE: {
+                    auto bits = load<uint32_t>(pCell);
+                    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+                }
+                case DDS_DOUBLE_TYPE: {
+                    auto bits = load<uint64_t>(pCell);
+                    return bits & 0x8000000000000000u ? ~bits : bits | 0x8000000000000000u;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+        // Scatters by the byte at shift, false when all keys share it and nothing moved
+        bool radixPass(std::vector<uint64_t> &keys, std::vector<size_t> &rows,
+                std::vector<uint64_t> &keysOut, std::vector<size_t> &rowsOut, unsigned shift) {
+            size_t count = keys.size();
+            size_t chunks = chunkCount(count);
+            size_t chunkRows = (count + chunks - 1) / chunks;
+            std::vector<std::array<size_t, 256>> offsets(chunks);
+
+            parallelFor(chunks, [&](size_t chunk) {
+                auto &histogram = offsets[chunk];
+                histogram.fill(0);
+                size_t end = std::min(count, (chunk + 1) * chunkRows);
+                for (size_t i = chunk * chunkRows; i < end; ++i) {
+                    ++histogram[(keys[i] >> shift) & 0xff];
+                }
+            });
+
+            size_t position = 0;
+            for (size_t digit = 0; digit != 256; ++digit) {
+                size_t digitCount = 0;
+                for (auto &histogram : offsets) {
+                    size_t rows = histogram[digit];
+                    histogram[digit] = position + digitCount;
+                    digitCount += rows;
+                }
+                if (digitCount == count) {
+                    return false;
+                }
+                position += digitCount;
+            }
+
+            parallelFor(chunks, [&](size_t chunk) {
+                auto &offset = offsets[chunk];
+                size_t end = std::min(count, (chunk + 1) * chunkRows);
+                for (size_t i = chunk * chunkRows; i < end; ++i) {
+                    size_t to = offset[(keys[i] >> shift) & 0xff]++;
+                    keysOut[to] = keys[i];
+                    rowsOut[to] = rows[i];
+                }
+            });
+            return true;
+        }
+
+        // LSD radix sort, one key after the other starting with the last
+        void radixSort(std::vector<KeyColumn> const &keys, bool descending,
+                std::vector<size_t> &order) {
+            size_t count = order.size();
+            size_t chunks = chunkCount(count);
+            size_t chunkRows = (count + chunks - 1) / chunks;
+            std::vector<uint64_t> radixKeys(count);
+            std::vector<uint64_t> keysOut(count);
+            std::vector<size_t> rowsOut(count);
+
+            for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+                DdsSize keyBytes = sizeOfType(key->type);
+                uint64_t mask = keyBytes == 8 ? ~uint64_t{0} : (uint64_t{1} << keyBytes * 8) - 1;
+                uint64_t flip = descending ? mask : 0;
+
+                parallelFor(chunks, [&, key](size_t chunk) {
+                    size_t end = std::min(count, (chunk + 1) * chunkRows);
+                    for (size_t i = chunk * chunkRows; i < end; ++i) {
+                        radixKeys[i] = radixKey(key->type, key->pData + order[i] * key->stride) ^
+                                flip;
+                    }
+                });
+
+                for (unsigned shift = 0; shift != keyBytes * 8; shift += 8) {
+                    if (radixPass(radixKeys, order, keysOut, rowsOut, shift)) {
+                        radixKeys.swap(keysOut);
+                        order.swap(rowsOut);
+                    }
+                }
+            }
+        }
+
+        template<typename T>
+        int compareValues(uint8_t const *pLeft, uint8_t const *pRight) {
+            auto left = load<T>(pLeft);
+            auto right = load<T>(pRight);
+            return left < right ? -1 : right < left ? 1 : 0;
+        }
+
+        // strings order by their characters, then by length
+        int compareStrings(DdsSize capacity, uint8_t const *pLeft, uint8_t const *pRight) {
+            auto leftLength = std::min(load<DdsSize>(pLeft), capacity);
+            auto rightLength = std::min(load<DdsSize>(pRight), capacity);
+            int result = std::memcmp(pLeft + sizeof(DdsSize), pRight + sizeof(DdsSize),
+                    std::min(leftLength, rightLength));
+            if (result != 0) {
+                return result;
+            }
+            return leftLength < rightLength ? -1 : rightLength < leftLength ? 1 : 0;
+        }
+
+        int compareCells(KeyColumn const &key, uint8_t const *pLeft, uint8_t const *pRight) {
+            switch (key.type) {
+                case DDS_INT32_TYPE:
+                    return compareValues<int32_t>(pLeft, pRight);
+                case DDS_UINT32_TYPE:
+                    return compareValues<uint32_t>(pLeft, pRight);
+                case DDS_INT64_TYPE:
+                    return compareValues<int64_t>(pLeft, pRight);
+                case DDS_UINT64_TYPE:
+                    return compareValues<uint64_t>(pLeft, pRight);
+                case DDS_FLOAT_TYPE:
+                    return compareValues<float>(pLeft, pRight);
+                case DDS_DOUBLE_TYPE:
+                    return compareValues<double>(pLeft, pRight);
+                case DDS_STRING_TYPE:
+                    return loadString(*key.pHeap, pLeft).compare(loadString(*key.pHeap, pRight));
+                default:
+                    return compareStrings(stringCapacity(key.type), pLeft, pRight);
+            }
+        }
+
+        // sorted chunks merged pairwise until one is left
+        void mergeSort(std::vector<KeyColumn> const &keys, bool descending,
+                std::vector<size_t> &order) {
+            auto less = [&keys, descending](size_t left, size_t right) {
+                for (auto const &key : keys) {
+                    int result = compareCells(key, key.pData + left * key.stride,
+                            key.pData + right * key.stride);
+                    if (result != 0) {
+                        return descending ? result > 0 : result < 0;
+                    }
+                }
+                return false;
+            };
+
+            size_t count = order.size();
+            size_t chunks = chunkCount(count);
+            size_t chunkRows = (count + chunks - 1) / chunks;
+            parallelFor(chunks, [&](size_t chunk) {
+                auto beg = order.begin() + std::min(count, chunk * chunkRows);
+                auto end = order.begin() + std::min(count, (chunk + 1) * chunkRows);
+                std::stable_sort(beg, end, less);
+            });
+
+            std::vector<size_t> merged(count);
+            for (size_t width = chunkRows; width < count; width *= 2) {
+                parallelFor((count + 2 * width - 1) / (2 * width), [&](size_t pair) {
+                    size_t beg = pair * 2 * width;
+                    size_t mid = std::min(count, beg + width);
+                    size_t end = std::min(count, beg + 2 * width);
+                    std::merge(order.begin() + beg, order.begin() + mid, order.begin() + mid,
+                            order.begin() + end, merged.begin() + beg, less);
+                });
+                order.swap(merged);
+            }
+        }
+
+        KeyColumn keyColumn(InstanceHelpers &components, InstanceData &data, DdsId column) {
+            DdsId table = data.columns.table[column];
+            DdsColumnData columnData;
+            if (auto aosId = components.tableAosData[table]) {
+                columnData = aosColumnData(data, *aosId, column);
+            } else {
+                columnData = soaColumnData(data, column);
+            }
+            return {columnData.pData, columnData.stride, data.columns.type[column],
+                    &data.columns.stringHeap[column]};
+        }
+
+        // gathers rows of size bytes each, in chunks of rows spread over the threads
+        void gatherRows(uint8_t *pData, size_t size, std::vector<size_t> const &order) {
+            size_t count = order.size();
+            std::vector<uint8_t> sorted(count * size);
+            size_t chunks = chunkCount(count);
+            size_t chunkRows = (count + chunks - 1) / chunks;
+            parallelFor(chunks, [&](size_t chunk) {
+                size_t end = std::min(count, (chunk + 1) * chunkRows);
+                for (size_t i = chunk * chunkRows; i < end; ++i) {
+                    std::memcpy(sorted.data() + i * size, pData + order[i] * size, size);
+                }
+            });
+            std::copy(sorted.begin(), sorted.end(), pData);
+        }
+    }
+
+    DdsResult sortOrder(InstanceHelpers &components, InstanceData &data, DdsId table,
+            DdsSize keyCount, DdsId const *pKeyColumns, DdsSortOrder sortOrder,
+            std::vector<size_t> &order) {
+        if (keyCount == 0) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        std::vector<KeyColumn> keys;
+        bool radix = true;
+        for (size_t i = 0; i != keyCount; ++i) {
+            DdsId column = pKeyColumns[i];
+            if (column >= data.columns.table.size() || data.columns.table[column] != table) {
+                return DDS_RESULT_COLUMN_NOT_EXIST;
+            }
+
+            DdsDataType type = data.columns.type[column];
+            if (!isRadixType(type) && stringCapacity(type) == 0 && type != DDS_STRING_TYPE) {
+                return DDS_RESULT_INVALID_TYPE;
+            }
+            radix = radix && isRadixType(type);
+            keys.push_back(keyColumn(components, data, column));
+        }
+
+        order.resize(rowCount(components, data, table));
+        std::iota(order.begin(), order.end(), 0);
+
+        bool descending = sortOrder == DDS_SORT_DESCENDING;
+        if (radix) {
+            radixSort(keys, descending, order);
+        } else {
+            mergeSort(keys, descending, order);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    void permuteRows(InstanceHelpers &components, InstanceData &data, DdsId table,
+            std::vector<size_t> const &order) {
+        if (auto aosId = components.tableAosData[table]) {
+            gatherRows(data.aosTables.data[*aosId].begin(), data.aosTables.rowSize[*aosId],
+                    order);
+            return;
+        }
+
+        for (DdsId column : components.tableColumns[table]) {
+            gatherRows(data.columns.soaColumnData[column].begin(),
+                    sizeOfType(data.columns.type[column]), order);
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "dds/data/helpers.hpp"
+#include <vector>
+
+namespace dds {
+    // Stable order of the rows of a table by the key columns, the first key deciding first.
+    // order[i] is the current position of the row sorted to i. Numeric keys are radix sorted,
+    // keys including a string are merge sorted.
+    DdsResult sortOrder(InstanceHelpers &components, InstanceData &data, DdsId table,
+            DdsSize keyCount, DdsId const *pKeyColumns, DdsSortOrder sortOrder,
+            std::vector<size_t> &order);
+
+    // Moves row order[i] to i in every column of the table
+    void permuteRows(InstanceHelpers &components, InstanceData &data, DdsId table,
+            std::vector<size_t> const &order);
+}
@@ -0,0 +1,364 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <unistd.h>
+
+namespace dds {
+    namespace {
+        constexpr char const *statNames[] = {
+                "ddsCreateInstance",
+                "ddsDeleteInstance",
+                "ddsSerialize",
+                "ddsSerializeAsync",
+                "ddsPollSerialize",
+                "ddsWaitSerialize",
+                "ddsDeleteSerializeJob",
+                "ddsCreateTable",
+                "ddsDeleteTable",
+                "ddsPrefetchTable",
+                "ddsFind",
+                "ddsMakeConnection",
+                "ddsFindChild",
+                "ddsFindChildren",
+                "ddsClusterChildren",
+                "ddsFindChildRange",
+                "ddsGetTablesCount",
+                "ddsGetTable",
+                "ddsGetTableName",
+                "ddsGetTableLength",
+                "ddsGetTableColumns",
+                "ddsGetColumn",
+                "ddsGetColumnName",
+                "ddsGetColumnType",
+                "ddsGetColumnOffset",
+                "ddsInsert",
+                "ddsInsertRows",
+                "ddsImport",
+                "ddsExportArrow",
+                "ddsImportArrow",
+                "ddsRemove",
+                "ddsRemoveRows",
+                "ddsSortTable",
+                "ddsColumnData",
+                "ddsAosData",
+                "ddsStringHeap",
+                "ddsGetMemoryStats",
+                "ddsRecordInsert",
+                "ddsRecordRemove",
+                "ddsRecordUpdate",
+                "ddsFlushCommands",
+                "ddsRegisterComponent",
+                "ddsCreateEntities",
+                "ddsDestroyEntities",
+                "ddsAddComponent",
+                "ddsRemoveComponent",
+                "ddsGetEntity",
+                "ddsQueryArchetypes",
+                "index.build",
+                "listeners.insert",
+                "listeners.remove",
+                "listeners.permute",
+                "strings.compact",
+                "wal.sync",
+                "segment.write",
+                "segment.load",
+                "mapped.checkpoint",
+        };
+        static_assert(std::size(statNames) == statCount, "a stat has no name");
+    }
+
+    char const *statName(Stat stat) {
+        return statNames[static_cast<size_t>(stat)];
+    }
+}
+
+#ifdef DDS_STATS
+
+namespace dds {
+    namespace {
+        // Values below 2 * subBuckets are exact, above that every power of two is split into
+        // subBuckets buckets, so a bucket is at most 1/32 of its value wide.
+        constexpr unsigned subBucketBits = 5;
+        constexpr uint64_t subBuckets = uint64_t(1) << subBucketBits;
+        constexpr size_t bucketCount = (64 - subBucketBits) * subBuckets;
+
+        constexpr size_t maxTraceEvents = size_t(1) << 20; // per thread
+
+        size_t bucketIndex(uint64_t value) {
+            if (value < 2 * subBuckets) {
+                return static_cast<size_t>(value);
+            }
+            unsigned shift = 63 - static_cast<unsigned>(__builtin_clzll(value)) - subBucketBits;
+            return (shift + 1) * subBuckets + ((value >> shift) - subBuckets);
+        }
+
+        // highest value that falls into the bucket
+        uint64_t bucketValue(size_t index) {
+            if (index < 2 * subBuckets) {
+                return index;
+            }
+            unsigned shift = static_cast<unsigned>(index / subBuckets) - 1;
+            uint64_t sub = index % subBuckets + subBuckets;
+            return ((sub + 1) << shift) - 1;
+        }
+
+        // Written by its thread only. Relaxed atomics let readers merge while it records.
+        class Histogram {
+        public:
+            void record(uint64_t value) {
+                increment(buckets[bucketIndex(value)], 1);
+                increment(count, 1);
+                increment(total, value);
+                if (value < min.load(std::memory_order_relaxed)) {
+                    min.store(value, std::memory_order_relaxed);
+                }
+                if (value > max.load(std::memory_order_relaxed)) {
+                    max.store(value, std::memory_order_relaxed);
+                }
+            }
+
+            void add(Histogram const &other) {
+                for (size_t i = 0; i != bucketCount; ++i) {
+                    increment(buckets[i], other.buckets[i].load(std::memory_order_relaxed));
+                }
+                increment(count, other.count.load(std::memory_order_relaxed));
+                increment(total, other.total.load(std::memory_order_relaxed));
+                min.store(std::min(min.load(std::memory_order_relaxed),
+                        other.min.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+                max.store(std::max(max.load(std::memory_order_relaxed),
+                        other.max.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            }
+
+            void reset() {
+                for (auto &bucket : buckets) {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+                count.store(0, std::memory_order_relaxed);
+                total.store(0, std::memory_order_relaxed);
+                min.store(UINT64_MAX, std::memory_order_relaxed);
+                max.store(0, std::memory_order_relaxed);
+            }
+
+            StatSummary summary(Stat stat) const {
+                StatSummary result{stat, count.load(std::memory_order_relaxed),
+                        total.load(std::memory_order_relaxed), min.load(std::memory_order_relaxed),
+                        max.load(std::memory_order_relaxed), 0, 0, 0, 0};
+
+                uint64_t *pPercentiles[] = {&result.p50Ns, &result.p90Ns, &result.p99Ns,
+                        &result.p999Ns};
+                double const fractions[] = {0.5, 0.9, 0.99, 0.999};
+                uint64_t seen = 0;
+                size_t next = 0;
+                for (size_t i = 0; i != bucketCount && next != std::size(fractions); ++i) {
+                    seen += buckets[i].load(std::memory_order_relaxed);
+                    while (next != std::size(fractions) &&
+                            static_cast<double>(seen) >= fractions[next] * result.count) {
+                        *pPercentiles[next++] = std::min(bucketValue(i), result.maxNs);
+                    }
+                }
+                return result;
+            }
+
+        private:
+            static void increment(std::atomic<uint64_t> &counter, uint64_t value) {
+                counter.store(counter.load(std::memory_order_relaxed) + value,
+                        std::memory_order_relaxed);
+            }
+
+            std::array<std::atomic<uint64_t>, bucketCount> buckets{};
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> total{0};
+            std::atomic<uint64_t> min{UINT64_MAX};
+            std::atomic<uint64_t> max{0};
+        };
+
+        struct TraceEvent {
+            Stat stat;
+            uint32_t thread;
+            uint64_t beginNs;
+            uint64_t durationNs;
+        };
+
+        // Histograms are allocated on the first record of their stat, a thread usually calls
+        // only a few entry points
+        struct ThreadStats {
+            ~ThreadStats() {
+                for (auto &histogram : histograms) {
+                    delete histogram.load(std::memory_order_relaxed);
+                }
+            }
+
+            Histogram &histogram(Stat stat) {
+                auto &slot = histograms[static_cast<size_t>(stat)];
+                Histogram *pHistogram = slot.load(std::memory_order_acquire);
+                if (!pHistogram) {
+                    pHistogram = new Histogram;
+                    slot.store(pHistogram, std::memory_order_release);
+                }
+                return *pHistogram;
+            }
+
+            std::array<std::atomic<Histogram *>, statCount> histograms{};
+            std::mutex traceMutex;
+            std::vector<TraceEvent> trace;
+            uint32_t thread = 0;
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<ThreadStats *> threads;
+            ThreadStats retired; // merged from threads that exited
+            std::atomic<bool> tracing{false};
+            uint32_t nextThread = 1;
+        };
+
+        // never destroyed, threads may still exit after static destruction began
+        Registry &registry() {
+            static auto *pRegistry = new Registry;
+            return *pRegistry;
+        }
+
+        struct ThreadHandle {
+            ThreadHandle() {
+                auto &reg = registry();
+                std::lock_guard lock(reg.mutex);
+                stats.thread = reg.nextThread++;
+                reg.threads.push_back(&stats);
+            }
+
+            ~ThreadHandle() {
+                auto &reg = registry();
+                std::lock_guard lock(reg.mutex);
+                for (size_t i = 0; i != statCount; ++i) {
+                    if (auto pHistogram = stats.histograms[i].load(std::memory_order_relaxed)) {
+                        reg.retired.histogram(static_cast<Stat>(i)).add(*pHistogram);
+                    }
+                }
+                {
+                    std::lock_guard traceLock(stats.traceMutex);
+                    reg.retired.trace.insert(reg.retired.trace.end(), stats.trace.begin(),
+                            stats.trace.end());
+                }
+                reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), &stats));
+            }
+
+            ThreadStats stats;
+        };
+
+        ThreadStats &threadStats() {
+            thread_local ThreadHandle handle;
+            return handle.stats;
+        }
+
+        void writeTrace(std::FILE *file, std::vector<TraceEvent> const &events) {
+            uint64_t originNs = UINT64_MAX;
+            for (auto const &event : events) {
+                originNs = std::min(originNs, event.beginNs);
+            }
+
+            auto pid = static_cast<int>(::getpid());
+            std::fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+            for (size_t i = 0; i != events.size(); ++i) {
+                auto const &event = events[i];
+                std::fprintf(file, "%s\n{\"name\": \"%s\", \"cat\": \"dds\", \"ph\": \"X\", "
+                        "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %u}", i ? "," : "",
+                        statName(event.stat), static_cast<double>(event.beginNs - originNs) / 1e3,
+                        static_cast<double>(event.durationNs) / 1e3, pid, event.thread);
+            }
+            std::fprintf(file, "\n]}\n");
+        }
+    }
+
+    uint64_t statClock() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void recordStat(Stat stat, uint64_t beginNs, uint64_t endNs) {
+        auto &stats = threadStats();
+        stats.histogram(stat).record(endNs - beginNs);
+
+        if (registry().tracing.load(std::memory_order_relaxed)) {
+            std::lock_guard lock(stats.traceMutex);
+            if (stats.trace.size() < maxTraceEvents) {
+                stats.trace.push_back({stat, stats.thread, beginNs, endNs - beginNs});
+            }
+        }
+    }
+
+    std::vector<StatSummary> collectStats() {
+        auto &reg = registry();
+        std::lock_guard lock(reg.mutex);
+
+        std::vector<StatSummary> result;
+        for (size_t i = 0; i != statCount; ++i) {
+            auto stat = static_cast<Stat>(i);
+            Histogram merged;
+            bool recorded = false;
+            auto add = [&merged, &recorded, i](ThreadStats const &stats) {
+                if (auto pHistogram = stats.histograms[i].load(std::memory_order_acquire)) {
+                    merged.add(*pHistogram);
+                    recorded = true;
+                }
+            };
+            add(reg.retired);
+            for (auto pStats : reg.threads) {
+                add(*pStats);
+            }
+            if (recorded) {
+                result.push_back(merged.summary(stat));
+            }
+        }
+        return result;
+    }
+
+    // Calls that are being recorded meanwhile may survive the reset
+    void resetStats() {
+        auto &reg = registry();
+        std::lock_guard lock(reg.mutex);
+        auto reset = [](ThreadStats &stats) {
+            for (auto &histogram : stats.histograms) {
+                if (auto pHistogram = histogram.load(std::memory_order_acquire)) {
+                    pHistogram->reset();
+                }
+            }
+        };
+        reset(reg.retired);
+        for (auto pStats : reg.threads) {
+            reset(*pStats);
+        }
+    }
+
+    void startTrace() {
+        registry().tracing.store(true, std::memory_order_relaxed);
+    }
+
+    bool stopTrace(std::string const &path) {
+        auto &reg = registry();
+        reg.tracing.store(false, std::memory_order_relaxed);
+
+        std::vector<TraceEvent> events;
+        {
+            std::lock_guard lock(reg.mutex);
+            events.swap(reg.retired.trace);
+            for (auto pStats : reg.threads) {
+                std::lock_guard traceLock(pStats->traceMutex);
+                events.insert(events.end(), pStats->trace.begin(), pStats->trace.end());
+                pStats->trace.clear();
+            }
+        }
+
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+        writeTrace(file, events);
+        return std::fclose(file) == 0;
+    }
+}
+
+#endif
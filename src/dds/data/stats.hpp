@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace dds {
+    enum class Stat : uint8_t {
+        CreateInstance,
+        DeleteInstance,
+        Serialize,
+        SerializeAsync,
+        PollSerialize,
+        WaitSerialize,
+        DeleteSerializeJob,
+        CreateTable,
+        DeleteTable,
+        PrefetchTable,
+        Find,
+        MakeConnection,
+        FindChild,
+        FindChildren,
+        ClusterChildren,
+        FindChildRange,
+        GetTablesCount,
+        GetTable,
+        GetTableName,
+        GetTableLength,
+        GetTableColumns,
+        GetColumn,
+        GetColumnName,
+        GetColumnType,
+        GetColumnOffset,
+        Insert,
+        InsertRows,
+        Import,
+        ExportArrow,
+        ImportArrow,
+        Remove,
+        RemoveRows,
+        SortTable,
+        ColumnData,
+        AosData,
+        StringHeap,
+        GetMemoryStats,
+        RecordInsert,
+        RecordRemove,
+        RecordUpdate,
+        FlushCommands,
+        RegisterComponent,
+        CreateEntities,
+        DestroyEntities,
+        AddComponent,
+        RemoveComponent,
+        GetEntity,
+        QueryArchetypes,
+        // internal paths
+        IndexBuild, // first ddsFind on a column
+        ListenersInsert, // index and connection maintenance after an insert
+        ListenersRemove, // index and connection maintenance before a remove
+        ListenersPermute, // index and connection maintenance after a sort
+        StringsCompact, // rewriting string heaps after removals
+        WalSync,
+        SegmentWrite,
+        SegmentLoad,
+        MappedCheckpoint,
+        Count,
+    };
+
+    constexpr size_t statCount = static_cast<size_t>(Stat::Count);
+
+    char const *statName(Stat stat);
+}
+
+#ifdef DDS_STATS
+
+namespace dds {
+    uint64_t statClock();
+
+    void recordStat(Stat stat, uint64_t beginNs, uint64_t endNs);
+
+    // Times its own lifetime into the histogram of the calling thread
+    class StatScope {
+    public:
+        explicit StatScope(Stat stat) : stat(stat), beginNs(statClock()) {}
+
+        StatScope(StatScope const &) = delete;
+
+        StatScope &operator=(StatScope const &) = delete;
+
+        ~StatScope() {
+            recordStat(stat, beginNs, statClock());
+        }
+
+    private:
+        Stat stat;
+        uint64_t beginNs;
+    };
+
+    struct StatSummary {
+        Stat stat;
+        uint64_t count;
+        uint64_t totalNs;
+        uint64_t minNs;
+        uint64_t maxNs;
+        uint64_t p50Ns;
+        uint64_t p90Ns;
+        uint64_t p99Ns;
+        uint64_t p999Ns;
+    };
+
+    // Merges the histograms of all threads, including finished ones. Stats never recorded are
+    // left out.
+    std::vector<StatSummary> collectStats();
+
+    void resetStats();
+
+    void startTrace();
+
+    // Writes the events recorded since startTrace in the Chrome trace event format
+    bool stopTrace(std::string const &path);
+}
+
+#define DDS_STAT_CONCAT_(a, b) a##b
+#define DDS_STAT_CONCAT(a, b) DDS_STAT_CONCAT_(a, b)
+#define DDS_STAT_SCOPE(stat) ::dds::StatScope DDS_STAT_CONCAT(statScope, __LINE__)(stat)
+
+#else
+
+#define DDS_STAT_SCOPE(stat) ((void) 0)
+
+#endif
@@ -0,0 +1,207 @@
+#include "strings.hpp"
+#include "stats.hpp"
+#include "table.hpp"
+#include "type.hpp"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace dds {
+    namespace {
+        // garbage below this is not worth a rewrite
+        constexpr DdsSize compactSlack = 64 * 1024;
+
+        DdsSize loadOffset(uint8_t const *pValues, DdsSize index) {
+            DdsSize offset;
+            std::memcpy(&offset, pValues + index * sizeof(DdsSize), sizeof(offset));
+            return offset;
+        }
+
+        // cells of aos tables may be unaligned
+        DdsStringRef loadCell(uint8_t const *pCell) {
+            DdsStringRef cell;
+            std::memcpy(&cell, pCell, sizeof(cell));
+            return cell;
+        }
+
+        void storeCell(uint8_t *pCell, DdsSize offset, DdsSize length) {
+            DdsStringRef cell{static_cast<DdsStringOffset>(offset),
+                    static_cast<DdsStringOffset>(length)};
+            std::memcpy(pCell, &cell, sizeof(cell));
+        }
+    }
+
+    void StringValues::add(std::string_view value) {
+        chars.insert(chars.end(), value.begin(), value.end());
+        offsets.push_back(chars.size());
+    }
+
+    void StringValues::add(DdsSize count, uint8_t const *pValues) {
+        for (DdsSize i = 0; i != count; ++i) {
+            add(stringValue(count, pValues, i));
+        }
+    }
+
+    std::vector<uint8_t> StringValues::bytes() const {
+        DdsSize header = offsets.size() * sizeof(DdsSize);
+        std::vector<uint8_t> result(header + chars.size());
+        std::memcpy(result.data(), offsets.data(), header);
+        std::copy(chars.begin(), chars.end(), result.begin() + header);
+        return result;
+    }
+
+    DdsSize stringValuesSize(DdsSize count, uint8_t const *pValues) {
+        return (count + 1) * sizeof(DdsSize) + loadOffset(pValues, count);
+    }
+
+    bool checkStringValues(DdsSize count, DdsData values) {
+        if (values.size / sizeof(DdsSize) <= count || loadOffset(values.pData, 0) != 0) {
+            return false;
+        }
+        for (DdsSize i = 0; i != count; ++i) {
+            if (loadOffset(values.pData, i + 1) < loadOffset(values.pData, i)) {
+                return false;
+            }
+        }
+        return stringValuesSize(count, values.pData) == values.size;
+    }
+
+    std::string_view stringValue(DdsSize count, uint8_t const *pValues, DdsSize index) {
+        auto pChars = reinterpret_cast<char const *>(pValues + (count + 1) * sizeof(DdsSize));
+        DdsSize begin = loadOffset(pValues, index);
+        return {pChars + begin, loadOffset(pValues, index + 1) - begin};
+    }
+
+    DdsSize valuesSize(DdsDataType type, DdsSize count, uint8_t const *pValues) {
+        if (type == DDS_STRING_TYPE) {
+            return stringValuesSize(count, pValues);
+        }
+        return count * sizeOfType(type);
+    }
+
+    bool checkValue(DdsDataType type, DdsData value) {
+        if (type == DDS_STRING_TYPE) {
+            return checkStringValues(1, value);
+        }
+        return value.size == sizeOfType(type);
+    }
+
+    void storeStrings(StringHeap &heap, DdsSize count, uint8_t const *pValues, uint8_t *pCells,
+            DdsSize stride) {
+        DdsSize base = heap.chars.size();
+        auto pChars = pValues + (count + 1) * sizeof(DdsSize);
+        heap.chars.insert(heap.chars.end(), pChars, pChars + loadOffset(pValues, count));
+
+        for (DdsSize i = 0; i != count; ++i) {
+            DdsSize begin = loadOffset(pValues, i);
+            storeCell(pCells + i * stride, base + begin, loadOffset(pValues, i + 1) - begin);
+        }
+    }
+
+    std::string_view loadString(StringHeap const &heap, uint8_t const *pCell) {
+        DdsStringRef cell = loadCell(pCell);
+        return {reinterpret_cast<char const *>(heap.chars.data()) + cell.offset, cell.length};
+    }
+
+    void replaceString(StringHeap &heap, uint8_t *pCell, std::string_view value) {
+        heap.garbage += loadCell(pCell).length;
+        storeCell(pCell, heap.chars.size(), value.size());
+        heap.chars.insert(heap.chars.end(), value.begin(), value.end());
+    }
+
+    void releaseStrings(InstanceHelpers &components, InstanceData &data, DdsId table,
+            DdsId position) {
+        for (DdsId column : components.tableColumns[table]) {
+            if (data.columns.type[column] == DDS_STRING_TYPE) {
+                uint8_t *pCell = cellData(components, data, column, position);
+                data.columns.stringHeap[column].garbage += loadCell(pCell).length;
+            }
+        }
+    }
+
+    void compactStrings(InstanceHelpers &components, InstanceData &data, DdsId table,
+            bool inPlace) {
+        DdsSize rows = rowCount(components, data, table);
+        for (DdsId column : components.tableColumns[table]) {
+            auto &heap = data.columns.stringHeap[column];
+            if (data.columns.type[column] != DDS_STRING_TYPE || heap.garbage < compactSlack ||
+                    2 * heap.garbage < heap.chars.size()) {
+                continue;
+            }
+
+            DDS_STAT_SCOPE(Stat::StringsCompact);
+            data::vector<uint8_t> chars;
+            chars.reserve(heap.chars.size() - heap.garbage);
+            for (DdsId row = 0; row != rows; ++row) {
+                uint8_t *pCell = cellData(components, data, column, row);
+                DdsStringRef cell = loadCell(pCell);
+                auto pChars = heap.chars.begin() + cell.offset;
+                storeCell(pCell, chars.size(), cell.length);
+                chars.insert(chars.end(), pChars, pChars + cell.length);
+            }
+            if (inPlace) {
+                std::copy(chars.begin(), chars.end(), heap.chars.begin());
+                heap.chars.resize(chars.size());
+            } else {
+                heap.chars = std::move(chars);
+            }
+            heap.garbage = 0;
+        }
+    }
+
+    DdsResult extendMappedHeaps(InstanceData &data, DdsId table) {
+        std::optional<size_t> aosId;
+        for (size_t i = 0; i != data.aosTables.table.size(); ++i) {
+            if (data.aosTables.table[i] == table) {
+                aosId = i;
+            }
+        }
+
+        for (size_t column = 0; column != data.columns.table.size(); ++column) {
+            if (data.columns.table[column] != table ||
+                    data.columns.type[column] != DDS_STRING_TYPE) {
+                continue;
+            }
+
+            uint8_t const *pCells = data.columns.soaColumnData[column].data();
+            size_t stride = sizeof(DdsStringRef);
+            size_t rows = data.columns.soaColumnData[column].size() / stride;
+            if (aosId) {
+                auto const &bytes = data.aosTables.data[*aosId];
+                stride = data.aosTables.rowSize[*aosId];
+                rows = stride ? bytes.size() / stride : 0;
+                pCells = bytes.data() + data.columns.aosColumnOffset[column];
+            }
+
+            auto &chars = data.columns.stringHeap[column].chars;
+            size_t end = chars.size();
+            for (size_t row = 0; row != rows; ++row) {
+                DdsStringRef cell = loadCell(pCells + row * stride);
+                end = std::max(end, size_t{cell.offset} + cell.length);
+            }
+            if (end > chars.allocated_size_) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+            pointAt(chars, chars.data(), end, chars.allocated_size_);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    bool hasStrings(InstanceHelpers &components, InstanceData &data, DdsId table) {
+        for (DdsId column : components.tableColumns[table]) {
+            if (data.columns.type[column] == DDS_STRING_TYPE) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t StringColumn::size() const {
+        return rowCount(*pComponents, *pData, pData->columns.table[column]);
+    }
+
+    std::string StringColumn::operator[](size_t position) const {
+        uint8_t *pCell = cellData(*pComponents, *pData, column, position);
+        return std::string(loadString(pData->columns.stringHeap[column], pCell));
+    }
+}
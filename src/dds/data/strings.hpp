@@ -0,0 +1,91 @@
+#pragma once
+
+#include "dds/data/helpers.hpp"
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dds {
+    // Largest heap of a column, cells address it with DdsStringOffset
+    constexpr DdsSize maxStringHeap = std::numeric_limits<DdsStringOffset>::max();
+
+    // Builds a buffer of DDS_STRING_TYPE values, offsets followed by the characters
+    class StringValues {
+    public:
+        void add(std::string_view value);
+
+        // every value of another buffer
+        void add(DdsSize count, uint8_t const *pValues);
+
+        std::vector<uint8_t> bytes() const;
+
+    private:
+        std::vector<DdsSize> offsets{0};
+        std::vector<uint8_t> chars;
+    };
+
+    // Size of a buffer holding count values, which is trusted to be well formed
+    DdsSize stringValuesSize(DdsSize count, uint8_t const *pValues);
+
+    // Offsets start at 0, never decrease and end with the characters
+    bool checkStringValues(DdsSize count, DdsData values);
+
+    // value index of a buffer holding count values
+    std::string_view stringValue(DdsSize count, uint8_t const *pValues, DdsSize index);
+
+    // Size of count values of the type as passed to inserts and updates
+    DdsSize valuesSize(DdsDataType type, DdsSize count, uint8_t const *pValues);
+
+    // one value of the type as passed to updates
+    bool checkValue(DdsDataType type, DdsData value);
+
+    // Appends the characters of the values to the heap and writes a cell for each of them
+    void storeStrings(StringHeap &heap, DdsSize count, uint8_t const *pValues, uint8_t *pCells,
+            DdsSize stride);
+
+    std::string_view loadString(StringHeap const &heap, uint8_t const *pCell);
+
+    // Points the cell at a new value, the old characters become garbage
+    void replaceString(StringHeap &heap, uint8_t *pCell, std::string_view value);
+
+    // The characters of a row about to be removed become garbage
+    void releaseStrings(InstanceHelpers &components, InstanceData &data, DdsId table,
+            DdsId position);
+
+    // Rewrites the heaps of the string columns of the table in row order once their garbage
+    // outweighs the live characters, leaving the offsets ascending like Arrow's. Heaps mapped
+    // from segment files are rewritten inPlace, where the cells rewritten along find them.
+    void compactStrings(InstanceHelpers &components, InstanceData &data, DdsId table,
+            bool inPlace);
+
+    // Heaps mapped by a MappedStore grow in place, cells written in place after the last
+    // checkpoint may point past the size in the manifest. Extends the heaps of the table over
+    // the characters they point at, DDS_RESULT_INVALID_DATA for cells past the mapped files.
+    DdsResult extendMappedHeaps(InstanceData &data, DdsId table);
+
+    bool hasStrings(InstanceHelpers &components, InstanceData &data, DdsId table);
+
+    // Values of a string column for IdMap, read from the column on every access so inserts,
+    // removes and compactions never leave it behind
+    class StringColumn {
+    public:
+        using value_type = std::string;
+
+        StringColumn(InstanceHelpers &components, InstanceData &data, DdsId column)
+                : pComponents(&components), pData(&data), column(column) {}
+
+        size_t size() const;
+
+        std::string operator[](size_t position) const;
+
+        std::string back() const {
+            return (*this)[size() - 1];
+        }
+
+    private:
+        InstanceHelpers *pComponents;
+        InstanceData *pData;
+        DdsId column;
+    };
+}
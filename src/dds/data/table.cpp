@@ -7,8 +7,8 @@ namespace dds {
             DdsSize count, DdsData const *pColumnData) {
         auto &bytes = data.aosTables.data[aosId];
         DdsSize rowSize = data.aosTables.rowSize[aosId];
-        bytes.resize(bytes.size() + count * rowSize);
         DdsSize currentSize = bytes.size();
+        bytes.resize(currentSize + count * rowSize);
 
         for (size_t i = 0; i != components.tableColumns[table].size(); ++i) {
             DdsSize column = components.tableColumns[table][i];
@@ -22,6 +22,13 @@ namespace dds {
         }
     }
 
+    void aosAppend(InstanceData &data, DdsId aosId, DdsData rows) {
+        auto &bytes = data.aosTables.data[aosId];
+        DdsSize currentSize = bytes.size();
+        bytes.resize(currentSize + rows.size);
+        std::copy(rows.pData, rows.pData + rows.size, bytes.begin() + currentSize);
+    }
+
     void aosRemove(InstanceData &data, DdsId aosId, DdsId position) {
         auto &bytes = data.aosTables.data[aosId];
         uint32_t rowSize = data.aosTables.rowSize[aosId];
@@ -37,7 +44,7 @@ namespace dds {
 
             auto &bytes = data.columns.soaColumnData[column];
             auto beg = pColumnData[i].pData;
-            std::copy(beg, beg + pColumnData[i].size, std::back_inserter(bytes));
+            bytes.insert(bytes.end(), beg, beg + pColumnData[i].size);
         }
     }
 
@@ -53,4 +60,31 @@ namespace dds {
             bytes.erase(bytes.end() - typeSize, bytes.end());
         }
     }
+
+    DdsSize rowCount(InstanceHelpers &components, InstanceData &data, DdsId table) {
+        if (auto aosId = components.tableAosData[table]) {
+            DdsSize rowSize = data.aosTables.rowSize[*aosId];
+            return rowSize ? data.aosTables.data[*aosId].size() / rowSize : 0;
+        }
+
+        auto const &columns = components.tableColumns[table];
+        if (columns.empty()) {
+            return 0;
+        }
+        DdsId column = columns[0];
+        return data.columns.soaColumnData[column].size() / sizeOfType(data.columns.type[column]);
+    }
+
+    uint8_t *cellData(InstanceHelpers &components, InstanceData &data, DdsId column,
+            DdsId position) {
+        DdsId table = data.columns.table[column];
+        if (auto aosId = components.tableAosData[table]) {
+            DdsSize rowSize = data.aosTables.rowSize[*aosId];
+            return data.aosTables.data[*aosId].begin() + position * rowSize
+                   + data.columns.aosColumnOffset[column];
+        } else {
+            DdsSize typeSize = sizeOfType(data.columns.type[column]);
+            return data.columns.soaColumnData[column].begin() + position * typeSize;
+        }
+    }
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
-#include "dds/data/instance.hpp"
+#include "dds/data/helpers.hpp"
+#include <limits>
 
 namespace dds {
     void aosInsert(InstanceHelpers &components, InstanceData &data, DdsId table, DdsId aosId,
             DdsSize count, DdsData const *pColumnData);
 
+    // Appends rows already laid out like the table, size is count * rowSize
+    void aosAppend(InstanceData &data, DdsId aosId, DdsData rows);
+
     void aosRemove(InstanceData &data, DdsId aosId, DdsId position);
 
     void soaInsert(InstanceHelpers &components, InstanceData &data, DdsId table,
@@ -12,4 +16,13 @@ namespace dds {
 
     void soaRemove(InstanceHelpers &components, InstanceData &data, DdsId table,
             DdsId position);
+
+    DdsSize rowCount(InstanceHelpers &components, InstanceData &data, DdsId table);
+
+    // Rows a table can hold while indices and connections address them, the largest position
+    // marks missing rows
+    constexpr DdsSize maxIndexedRows = std::numeric_limits<DdsRowIndex>::max();
+
+    uint8_t *cellData(InstanceHelpers &components, InstanceData &data, DdsId column,
+            DdsId position);
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "type.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 namespace dds {
 
@@ -48,10 +51,48 @@ namespace dds {
                 return sizeof(DdsMat3F);
             case DDS_MAT4F_TYPE:
                 return sizeof(DdsMat4F);
+            case DDS_STRING_TYPE:
+                return sizeof(DdsStringRef);
         }
         return 0;
     }
 
+    DdsSize componentCount(DdsDataType type) {
+        switch (type) {
+            case DDS_VEC2F_TYPE:
+                return 2;
+            case DDS_VEC3F_TYPE:
+                return 3;
+            case DDS_VEC4F_TYPE:
+                return 4;
+            case DDS_MAT3F_TYPE:
+                return 9;
+            case DDS_MAT4F_TYPE:
+                return 16;
+            default:
+                return 1;
+        }
+    }
+
+    DdsSize stringCapacity(DdsDataType type) {
+        switch (type) {
+            case DDS_STRING16_TYPE:
+                return sizeof(DdsString16::str);
+            case DDS_STRING64_TYPE:
+                return sizeof(DdsString64::str);
+            case DDS_STRING256_TYPE:
+                return sizeof(DdsString256::str);
+            default:
+                return 0;
+        }
+    }
+
+    void storeString(uint8_t *pDst, DdsDataType type, char const *pText, size_t size) {
+        DdsSize length = std::min<DdsSize>(size, stringCapacity(type));
+        std::memcpy(pDst, &length, sizeof(length));
+        std::memcpy(pDst + offsetof(DdsString16, str), pText, length);
+    }
+
     DdsSize std140Alignment(DdsDataType type) {
         if (isComplexType(type)) {
             return 16;
@@ -61,16 +102,33 @@ namespace dds {
     }
 
     DdsSize cAlignment(DdsDataType type) {
-        if (isComplexType(type)) {
-            return 0;
-        } else {
-            return sizeOfType(type);
+        switch (type) {
+            case DDS_STRING16_TYPE:
+                return alignof(DdsString16);
+            case DDS_STRING64_TYPE:
+                return alignof(DdsString64);
+            case DDS_STRING256_TYPE:
+                return alignof(DdsString256);
+            case DDS_VEC2F_TYPE:
+                return alignof(DdsVec2F);
+            case DDS_VEC3F_TYPE:
+                return alignof(DdsVec3F);
+            case DDS_VEC4F_TYPE:
+                return alignof(DdsVec4F);
+            case DDS_MAT3F_TYPE:
+                return alignof(DdsMat3F);
+            case DDS_MAT4F_TYPE:
+                return alignof(DdsMat4F);
+            case DDS_STRING_TYPE:
+                return alignof(DdsStringRef);
+            default:
+                return sizeOfType(type);
         }
     }
 
-    DdsSize aline(size_t offset, uint32_t alignment) {
+    DdsSize aline(DdsSize offset, DdsSize alignment) {
         if (alignment) {
-            return offset + (alignment - offset % alignment);
+            return (offset + alignment - 1) / alignment * alignment;
         } else {
             return offset;
         }
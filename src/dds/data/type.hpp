@@ -1,11 +1,21 @@
 #pragma once
-#include "src/dds/dds.h"
+#include "dds/dds.h"
+#include <cstddef>
 
 namespace dds {
     bool isComplexType(DdsDataType type);
 
     DdsSize sizeOfType(DdsDataType type);
 
+    // float components of a vector or matrix, 1 for every other type
+    DdsSize componentCount(DdsDataType type);
+
+    // characters a string type holds, 0 for every other type
+    DdsSize stringCapacity(DdsDataType type);
+
+    // Stores text as a string of the given type, longer text is cut to its capacity
+    void storeString(uint8_t *pDst, DdsDataType type, char const *pText, size_t size);
+
     DdsSize std140Alignment(DdsDataType type);
 
     DdsSize cAlignment(DdsDataType type);
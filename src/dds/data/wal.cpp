@@ -0,0 +1,209 @@
+#include "wal.hpp"
+#include "segment.hpp"
+#include "stats.hpp"
+#include "dds/helpers/checksum.hpp"
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dds {
+    namespace {
+        // payload size, crc of everything after it, lsn, record type
+        constexpr size_t frameHeaderSize = sizeof(uint32_t) * 2 + sizeof(uint64_t) + 1;
+
+        bool writeAll(int fd, uint8_t const *pData, size_t size) {
+            while (size != 0) {
+                ssize_t written = ::write(fd, pData, size);
+                if (written < 0) {
+                    return false;
+                }
+                pData += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        bool readAll(int fd, std::vector<uint8_t> &bytes) {
+            off_t fileSize = ::lseek(fd, 0, SEEK_END);
+            bytes.resize(fileSize > 0 ? static_cast<size_t>(fileSize) : 0);
+            return ::pread(fd, bytes.data(), bytes.size(), 0) ==
+                   static_cast<ssize_t>(bytes.size());
+        }
+    }
+
+    WalWriter::WalWriter(std::string path, uint64_t lastLsn) : path(std::move(path)),
+            appendedLsn(lastLsn), writtenLsn(lastLsn) {
+        fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    }
+
+    WalWriter::~WalWriter() {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+
+    DdsResult WalWriter::append(WalRecordType type, WalEncoder const &record) {
+        std::lock_guard lock(mutex);
+        if (failed) {
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        uint64_t lsn = ++appendedLsn;
+        auto size = static_cast<uint32_t>(record.bytes.size());
+        auto typeByte = static_cast<uint8_t>(type);
+
+        uint32_t crc = crc32(&lsn, sizeof(lsn));
+        crc = crc32(&typeByte, sizeof(typeByte), crc);
+        crc = crc32(record.bytes.data(), record.bytes.size(), crc);
+
+        WalEncoder header;
+        header.put(size).put(crc).put(lsn).put(typeByte);
+        pending.insert(pending.end(), header.bytes.begin(), header.bytes.end());
+        pending.insert(pending.end(), record.bytes.begin(), record.bytes.end());
+
+        return batching ? DDS_RESULT_SUCCESS : flush();
+    }
+
+    void WalWriter::beginBatch() {
+        std::lock_guard lock(mutex);
+        batching = true;
+    }
+
+    DdsResult WalWriter::endBatch() {
+        std::lock_guard lock(mutex);
+        batching = false;
+        return flush();
+    }
+
+    DdsResult WalWriter::flush() {
+        if (failed) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        if (pending.empty()) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        bool ok;
+        {
+            DDS_STAT_SCOPE(Stat::WalSync);
+            ok = writeAll(fd, pending.data(), pending.size()) && ::fdatasync(fd) == 0;
+        }
+        pending.clear();
+        if (!ok) {
+            // a torn record may follow, nothing is appended behind it
+            failed = true;
+            return DDS_RESULT_IO_ERROR;
+        }
+        writtenLsn = appendedLsn;
+        return DDS_RESULT_SUCCESS;
+    }
+
+    uint64_t WalWriter::lastLsn() {
+        std::lock_guard lock(mutex);
+        return appendedLsn;
+    }
+
+    DdsResult WalWriter::truncate(uint64_t lsn) {
+        std::lock_guard lock(mutex);
+        if (writtenLsn <= lsn) {
+            if (::ftruncate(fd, 0) != 0 || ::fdatasync(fd) != 0) {
+                return DDS_RESULT_IO_ERROR;
+            }
+            return DDS_RESULT_SUCCESS;
+        }
+
+        // records written while an async snapshot was in progress are kept
+        std::vector<uint8_t> bytes;
+        int readFd = ::open(path.c_str(), O_RDONLY);
+        bool read = readFd != -1 && readAll(readFd, bytes);
+        if (readFd != -1) {
+            ::close(readFd);
+        }
+        if (!read) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        size_t offset = 0;
+        while (bytes.size() - offset >= frameHeaderSize) {
+            WalDecoder header(bytes.data() + offset, frameHeaderSize);
+            auto size = header.get<uint32_t>();
+            header.get<uint32_t>();
+            if (header.get<uint64_t>() > lsn || bytes.size() - offset - frameHeaderSize < size) {
+                break;
+            }
+            offset += frameHeaderSize + size;
+        }
+
+        std::string tmpPath = path + ".tmp";
+        int tmpFd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (tmpFd == -1) {
+            return DDS_RESULT_IO_ERROR;
+        }
+        if (!writeAll(tmpFd, bytes.data() + offset, bytes.size() - offset) ||
+                ::fdatasync(tmpFd) != 0 || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            ::close(tmpFd);
+            ::unlink(tmpPath.c_str());
+            return DDS_RESULT_IO_ERROR;
+        }
+        ::close(fd);
+        fd = tmpFd;
+
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        return syncDirectory(dir.empty() ? "." : dir);
+    }
+
+    std::string walPath(std::string const &snapshotPath) {
+        return snapshotPath + ".wal";
+    }
+
+    DdsResult readWal(std::string const &path, uint64_t snapshotLsn, uint64_t *pLastLsn,
+            std::vector<uint8_t> &bytes, std::vector<WalFrame> &frames) {
+        *pLastLsn = snapshotLsn;
+
+        int fd = ::open(path.c_str(), O_RDWR);
+        if (fd == -1) {
+            // no log yet
+            return DDS_RESULT_SUCCESS;
+        }
+
+        if (!readAll(fd, bytes)) {
+            ::close(fd);
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        size_t offset = 0;
+        while (bytes.size() - offset >= frameHeaderSize) {
+            WalDecoder header(bytes.data() + offset, frameHeaderSize);
+            auto size = header.get<uint32_t>();
+            auto crc = header.get<uint32_t>();
+            auto lsn = header.get<uint64_t>();
+            auto type = header.get<uint8_t>();
+
+            if (bytes.size() - offset - frameHeaderSize < size) {
+                break;
+            }
+
+            uint8_t const *pPayload = bytes.data() + offset + frameHeaderSize;
+            uint32_t actual = crc32(&lsn, sizeof(lsn));
+            actual = crc32(&type, sizeof(type), actual);
+            actual = crc32(pPayload, size, actual);
+            if (actual != crc) {
+                break;
+            }
+
+            if (lsn > snapshotLsn) {
+                frames.push_back({lsn, static_cast<WalRecordType>(type), WalDecoder(pPayload, size)});
+                *pLastLsn = lsn;
+            }
+            offset += frameHeaderSize + size;
+        }
+
+        // a crash in the middle of an append leaves a torn record that must not be followed
+        if (offset != bytes.size() && ::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            ::close(fd);
+            return DDS_RESULT_IO_ERROR;
+        }
+
+        ::close(fd);
+        return DDS_RESULT_SUCCESS;
+    }
+}
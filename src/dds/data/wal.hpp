@@ -0,0 +1,162 @@
+#pragma once
+
+#include "dds/dds.h"
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dds {
+    enum class WalRecordType : uint8_t {
+        CreateTable,
+        DeleteTable,
+        Insert,
+        Remove,
+        Update,
+        Sort,
+        RemoveRows,
+    };
+
+    class WalEncoder {
+    public:
+        template<typename T>
+        WalEncoder &put(T const &value) {
+            auto beg = reinterpret_cast<uint8_t const *>(&value);
+            bytes.insert(bytes.end(), beg, beg + sizeof(T));
+            return *this;
+        }
+
+        WalEncoder &putBytes(void const *pData, DdsSize size) {
+            put(size);
+            auto beg = static_cast<uint8_t const *>(pData);
+            bytes.insert(bytes.end(), beg, beg + size);
+            return *this;
+        }
+
+        WalEncoder &putString(char const *str) {
+            return putBytes(str, std::strlen(str));
+        }
+
+        std::vector<uint8_t> bytes;
+    };
+
+    class WalDecoder {
+    public:
+        WalDecoder(uint8_t const *pData, size_t size) : pData(pData), pEnd(pData + size) {}
+
+        template<typename T>
+        T get() {
+            T value{};
+            if (check(sizeof(T))) {
+                std::memcpy(&value, pData, sizeof(T));
+                pData += sizeof(T);
+            }
+            return value;
+        }
+
+        DdsData getBytes() {
+            DdsSize size = get<DdsSize>();
+            DdsData result{pData, check(size) ? size : 0};
+            pData += result.size;
+            return result;
+        }
+
+        std::string getString() {
+            DdsData data = getBytes();
+            return std::string(reinterpret_cast<char const *>(data.pData), data.size);
+        }
+
+        bool valid() const {
+            return !overflow;
+        }
+
+    private:
+        bool check(size_t size) {
+            if (static_cast<size_t>(pEnd - pData) < size) {
+                overflow = true;
+            }
+            return !overflow;
+        }
+
+        uint8_t const *pData;
+        uint8_t const *pEnd;
+        bool overflow = false;
+    };
+
+    // Append-only log of instance changes. Each append is durable when it returns, paying one
+    // fdatasync. Between beginBatch and endBatch records collect in memory and endBatch makes
+    // all of them durable with a single fdatasync.
+    class WalWriter {
+    public:
+        WalWriter(std::string path, uint64_t lastLsn);
+
+        WalWriter(WalWriter const &) = delete;
+
+        WalWriter &operator=(WalWriter const &) = delete;
+
+        ~WalWriter();
+
+        bool isOpen() const {
+            return fd != -1;
+        }
+
+        DdsResult append(WalRecordType type, WalEncoder const &record);
+
+        void beginBatch();
+
+        DdsResult endBatch();
+
+        // lsn of the last appended record
+        uint64_t lastLsn();
+
+        // Drops the records up to lsn once a snapshot containing them was written. Records
+        // written after lsn are copied into a new log renamed over the old one, appends wait.
+        DdsResult truncate(uint64_t lsn);
+
+    private:
+        // writes and syncs the pending records, the mutex is held
+        DdsResult flush();
+
+        std::string path;
+        int fd = -1;
+
+        std::mutex mutex;
+        std::vector<uint8_t> pending;
+        uint64_t appendedLsn;
+        uint64_t writtenLsn; // last record in the file
+        bool batching = false;
+        bool failed = false;
+    };
+
+    std::string walPath(std::string const &snapshotPath);
+
+    struct WalFrame {
+        uint64_t lsn;
+        WalRecordType type;
+        WalDecoder decoder;
+    };
+
+    // Reads every intact record with lsn greater than snapshotLsn and cuts off a torn tail left
+    // by a crash. Frames point into bytes. pLastLsn receives the lsn of the last intact record.
+    DdsResult readWal(std::string const &path, uint64_t snapshotLsn, uint64_t *pLastLsn,
+            std::vector<uint8_t> &bytes, std::vector<WalFrame> &frames);
+
+    // Calls f(type, decoder) for every record returned by readWal
+    template<typename FnT>
+    DdsResult replayWal(std::string const &path, uint64_t snapshotLsn, uint64_t *pLastLsn, FnT &&f) {
+        std::vector<uint8_t> bytes;
+        std::vector<WalFrame> frames;
+        DdsResult result = readWal(path, snapshotLsn, pLastLsn, bytes, frames);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        for (auto &frame : frames) {
+            result = f(frame.type, frame.decoder);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+}
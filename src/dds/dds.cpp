@@ -1,5 +1,7 @@
 #include "dds.h"
 #include <filesystem>
+#include <map>
+#include <unordered_set>
 #include <cista/serialization.h>
 #include "dds/data/instance.hpp"
 #include "dds/data/column.hpp"
@@ -9,52 +11,716 @@
 #include "dds/helpers/TableListener.hpp"
 #include "dds/data/allocator.hpp"
 #include "dds/data/helpers.hpp"
-#include "dds/data/serialization.hpp"
-#include "dds/data/components.hpp"
+#include "dds/data/commands.hpp"
+#include "dds/data/type.hpp"
+#include "dds/data/wal.hpp"
+#include "dds/data/segment.hpp"
+#include "dds/data/mapped.hpp"
+#include "dds/data/snapshot.hpp"
+#include "dds/data/import.hpp"
+#include "dds/data/arrow.hpp"
+#include "dds/data/arena.hpp"
+#include "dds/data/stats.hpp"
+#include "dds/data/archetype.hpp"
+#include "dds/data/sort.hpp"
+#include "dds/data/cluster.hpp"
+#include "dds/data/strings.hpp"
 
 namespace fs = std::filesystem;
 
 struct DdsInstanceT {
     dds::SerializeInfo info;
-    dds::SearchHelpers components;
+    dds::InstanceHelpers components;
+    std::unique_ptr<dds::SizeClassPool> indexPool{}; // outlives the index maps
+    std::vector<std::shared_ptr<void>> columnViews{}; // read by index maps and connections
     std::unordered_map<DdsId, dds::TableListener> tableListeners{};
     dds::IdMaps idMaps{};
     dds::ColumnConnections connections{};
+    std::unordered_map<DdsId, bool> clusters{}; // clustered child parent columns, true if unsorted
+    dds::CommandBuffers commands{};
+    std::shared_ptr<dds::WalWriter> wal{}; // shared with serialize jobs
+    std::unique_ptr<dds::SegmentState> segments{};
+    std::unique_ptr<dds::MappedStore> store{};
+    std::unique_ptr<dds::ArenaStore> arenas{};
+    std::unique_ptr<dds::Archetypes> archetypes{}; // built on first use
 };
 
+struct DdsSerializeJobT {
+    dds::SnapshotJob job;
+};
+
+namespace {
+    // segments of a table opened with DDS_INSTANCE_CREATE_LAZY are read on first access
+    DdsResult ensureLoaded(DdsInstance instance, DdsId table) {
+        if (!instance->segments || instance->segments->loaded[table]) {
+            return DDS_RESULT_SUCCESS;
+        }
+        DdsResult result = dds::loadTable(*instance->info.data, instance->info.path,
+                *instance->segments, instance->store.get(), table);
+        if (result != DDS_RESULT_SUCCESS || !instance->arenas) {
+            return result;
+        }
+
+        for (auto pBytes : dds::tableRegions(*instance->info.data, table)) {
+            result = instance->arenas->reserve(*pBytes, table, pBytes->size());
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // Positions recorded for a flush are checked when the table is in memory, the flush checks
+    // them again either way
+    bool recordedRowExists(DdsInstance instance, DdsId table, DdsId position) {
+        if (instance->segments && !instance->segments->loaded[table]) {
+            return true;
+        }
+        return position < dds::rowCount(instance->components, *instance->info.data, table);
+    }
+
+    // Runs f with the log records of all its changes made durable by a single sync at the end
+    template<typename FnT>
+    DdsResult logBatch(DdsInstance instance, FnT &&f) {
+        if (!instance->wal) {
+            return f();
+        }
+        instance->wal->beginBatch();
+        DdsResult result = f();
+        DdsResult synced = instance->wal->endBatch();
+        return result != DDS_RESULT_SUCCESS ? result : synced;
+    }
+
+    dds::Archetypes &archetypes(DdsInstance instance) {
+        if (!instance->archetypes) {
+            instance->archetypes = std::make_unique<dds::Archetypes>(instance);
+        }
+        return *instance->archetypes;
+    }
+
+    // Heaps of a segmented instance opened with DDS_INSTANCE_CREATE_MMAP_WRITE grow in their
+    // mapped segment files, so cells written in place never point past what is on disk
+    DdsResult reserveChars(DdsInstance instance, DdsId column, DdsSize count,
+            uint8_t const *pValues) {
+        if (!instance->store) {
+            return DDS_RESULT_SUCCESS;
+        }
+        auto &chars = instance->info.data->columns.stringHeap[column].chars;
+        DdsSize size = dds::stringValuesSize(count, pValues) - (count + 1) * sizeof(DdsSize);
+        return instance->store->reserve(chars, chars.size() + size, instance->segments->nextFile);
+    }
+
+    DdsResult updateValue(DdsInstance instance, DdsId column, DdsId position,
+            uint8_t const *pValue) {
+        auto &data = *instance->info.data;
+        DdsDataType type = data.columns.type[column];
+        DdsId table = data.columns.table[column];
+
+        DdsResult result = ensureLoaded(instance, table);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+        if (position >= dds::rowCount(instance->components, data, table)) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+
+        DdsSize size = dds::valuesSize(type, 1, pValue);
+        if (type == DDS_STRING_TYPE &&
+                size > dds::maxStringHeap - data.columns.stringHeap[column].chars.size()) {
+            return DDS_RESULT_OUT_OF_MEMORY;
+        }
+
+        if (type == DDS_STRING_TYPE) {
+            result = reserveChars(instance, column, 1, pValue);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        if (instance->wal) {
+            dds::WalEncoder record;
+            record.put(column).put(position).put(type).putBytes(pValue, size);
+            result = instance->wal->append(dds::WalRecordType::Update, record);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        uint8_t *pCell = dds::cellData(instance->components, data, column, position);
+
+        if (type == DDS_STRING_TYPE) {
+            auto &heap = data.columns.stringHeap[column];
+            std::string_view value = dds::stringValue(1, pValue, 0);
+            auto iter = instance->idMaps.strings.find(column);
+            if (iter != instance->idMaps.strings.end()) {
+                iter->second.replace(std::string(dds::loadString(heap, pCell)),
+                        std::string(value), position);
+            }
+            dds::replaceString(heap, pCell, value);
+            dds::compactStrings(instance->components, data, table, instance->store != nullptr);
+
+            if (instance->segments) {
+                instance->segments->markDirty(table);
+            }
+            return DDS_RESULT_SUCCESS;
+        }
+
+        dds::getTypeMap(instance->idMaps, pValue, type,
+                [column, position, pCell](auto &map, auto value) {
+                    using value_type = std::decay_t<decltype(value)>;
+
+                    auto iter = map.find(column);
+                    if (iter != map.end()) {
+                        auto const &oldValue = *reinterpret_cast<value_type const *>(pCell);
+                        iter->second.replace(oldValue, value, position);
+                    }
+                    return DDS_RESULT_SUCCESS;
+                });
+
+        std::copy(pValue, pValue + dds::sizeOfType(type), pCell);
+
+        if (instance->segments) {
+            instance->segments->markDirty(data.columns.table[column]);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // Grows buffers in mapped segment files or the table arena up front, cista would move the
+    // data to its own heap memory otherwise
+    DdsResult reserveRows(DdsInstance instance, DdsId table, DdsSize count) {
+        if (!instance->store && !instance->arenas) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        auto &data = *instance->info.data;
+        auto &components = instance->components;
+        auto reserve = [instance, table](dds::data::vector<uint8_t> &bytes, size_t size) {
+            if (instance->store) {
+                return instance->store->reserve(bytes, size, instance->segments->nextFile);
+            }
+            return instance->arenas->reserve(bytes, table, size);
+        };
+
+        if (auto aosId = components.tableAosData[table]) {
+            auto &bytes = data.aosTables.data[*aosId];
+            DdsSize rowSize = data.aosTables.rowSize[*aosId];
+            return reserve(bytes, bytes.size() + count * rowSize);
+        }
+
+        for (DdsId column : components.tableColumns[table]) {
+            auto &bytes = data.columns.soaColumnData[column];
+            DdsSize typeSize = dds::sizeOfType(data.columns.type[column]);
+            DdsResult result = reserve(bytes, bytes.size() + count * typeSize);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // f(column, childTable) for the connections with the table as parent
+    template<typename FnT>
+    void forEachChildConnection(DdsInstance instance, DdsId table, FnT &&f) {
+        for (auto const &[column, parent] : instance->connections.parents) {
+            if (parent == table) {
+                f(column, instance->info.data->columns.table[column]);
+            }
+        }
+    }
+
+    bool reachesTable(DdsInstance instance, DdsId from, DdsId to) {
+        bool result = from == to;
+        forEachChildConnection(instance, from, [instance, to, &result](DdsId, DdsId child) {
+            result = result || reachesTable(instance, child, to);
+        });
+        return result;
+    }
+
+    // the table and the tables below it, children before their parents
+    void cascadeOrder(DdsInstance instance, DdsId table, std::unordered_set<DdsId> &visited,
+            std::vector<DdsId> &order) {
+        if (!visited.insert(table).second) {
+            return;
+        }
+        forEachChildConnection(instance, table, [instance, &visited, &order](DdsId, DdsId child) {
+            cascadeOrder(instance, child, visited, order);
+        });
+        order.push_back(table);
+    }
+
+    // Removes rows of one table in a single pass. Rows are sorted highest first, so the last
+    // rows moved into the holes are never ones still to be removed.
+    DdsResult removeTableRows(DdsInstance instance, DdsId table, std::vector<DdsId> const &rows) {
+        auto &data = *instance->info.data;
+        auto &components = instance->components;
+        if (rows.empty()) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        DdsResult result = ensureLoaded(instance, table);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        if (instance->wal) {
+            dds::WalEncoder record;
+            record.put(table).put(DdsSize(rows.size()));
+            for (DdsId row : rows) {
+                record.put(row);
+            }
+            result = instance->wal->append(dds::WalRecordType::RemoveRows, record);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        auto &tableListener = instance->tableListeners[table];
+        auto aosId = components.tableAosData[table];
+        bool strings = dds::hasStrings(components, data, table);
+        for (DdsId row : rows) {
+            {
+                DDS_STAT_SCOPE(dds::Stat::ListenersRemove);
+                tableListener.doRemove(row);
+            }
+
+            if (strings) {
+                dds::releaseStrings(components, data, table, row);
+            }
+            if (aosId) {
+                dds::aosRemove(data, *aosId, row);
+            } else {
+                dds::soaRemove(components, data, table, row);
+            }
+        }
+
+        if (strings) {
+            dds::compactStrings(components, data, table, instance->store != nullptr);
+        }
+        if (instance->segments) {
+            instance->segments->markDirty(table);
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // Removes the rows of every table and every row below them through connections. All rows
+    // are collected before the first removal, then child tables are removed before their parents
+    // so the connections never see a parent go while it has children.
+    DdsResult removeCascade(DdsInstance instance,
+            std::unordered_map<DdsId, std::vector<DdsId>> tableRows) {
+        auto &connections = instance->connections;
+        std::unordered_set<DdsId> visited;
+        std::vector<DdsId> order;
+        for (auto const &[table, rows] : tableRows) {
+            cascadeOrder(instance, table, visited, order);
+        }
+
+        for (auto iter = order.rbegin(); iter != order.rend(); ++iter) {
+            auto &parentRows = tableRows[*iter];
+            std::sort(parentRows.rbegin(), parentRows.rend());
+            parentRows.erase(std::unique(parentRows.begin(), parentRows.end()), parentRows.end());
+
+            forEachChildConnection(instance, *iter,
+                    [&connections, &tableRows, &parentRows](DdsId column, DdsId child) {
+                        auto &childRows = tableRows[child];
+                        auto multi = connections.multi.find(column);
+                        if (multi != connections.multi.end()) {
+                            for (DdsId parent : parentRows) {
+                                auto children = multi->second[parent];
+                                childRows.insert(childRows.end(), children.begin(),
+                                        children.end());
+                            }
+                        }
+                        auto single = connections.single.find(column);
+                        if (single != connections.single.end()) {
+                            for (DdsId parent : parentRows) {
+                                if (auto row = single->second[parent]) {
+                                    childRows.push_back(*row);
+                                }
+                            }
+                        }
+                    });
+        }
+
+        for (DdsId orderTable : order) {
+            DdsResult result = removeTableRows(instance, orderTable, tableRows[orderTable]);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // Appends columns that passed the checks of ddsInsert: grows the buffers, writes one log
+    // record and copies the values into the table
+    DdsResult appendColumns(DdsInstance instance, DdsId table, DdsSize count,
+            DdsSize columnCount, DdsDataType const *pColumnTypes, DdsData const *pColumnData) {
+        auto &data = *instance->info.data;
+        auto &components = instance->components;
+
+        // a logged insert has to succeed, so the buffers grow before the record is written
+        DdsResult result = reserveRows(instance, table, count);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        for (size_t i = 0; i != columnCount; ++i) {
+            if (pColumnTypes[i] == DDS_STRING_TYPE) {
+                result = reserveChars(instance, components.tableColumns[table][i], count,
+                        pColumnData[i].pData);
+                if (result != DDS_RESULT_SUCCESS) {
+                    return result;
+                }
+            }
+        }
+
+        if (instance->wal) {
+            dds::WalEncoder record;
+            record.put(table).put(count).put(columnCount);
+            for (size_t i = 0; i != columnCount; ++i) {
+                record.put(pColumnTypes[i]).putBytes(pColumnData[i].pData, pColumnData[i].size);
+            }
+            result = instance->wal->append(dds::WalRecordType::Insert, record);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        // characters of string columns go to their heaps, the rows get cells pointing there
+        std::vector<DdsData> columnData;
+        std::vector<std::vector<uint8_t>> cells;
+        if (dds::hasStrings(components, data, table)) {
+            columnData.assign(pColumnData, pColumnData + columnCount);
+            cells.resize(columnCount);
+            for (size_t i = 0; i != columnCount; ++i) {
+                if (pColumnTypes[i] == DDS_STRING_TYPE) {
+                    DdsId column = components.tableColumns[table][i];
+                    cells[i].resize(count * sizeof(DdsStringRef));
+                    dds::storeStrings(data.columns.stringHeap[column], count,
+                            pColumnData[i].pData, cells[i].data(), sizeof(DdsStringRef));
+                    columnData[i] = {cells[i].data(), cells[i].size()};
+                }
+            }
+            pColumnData = columnData.data();
+        }
+
+        if (auto aosId = components.tableAosData[table]) {
+            dds::aosInsert(components, data, table, *aosId, count, pColumnData);
+        } else {
+            dds::soaInsert(components, data, table, pColumnData);
+        }
+
+        {
+            DDS_STAT_SCOPE(dds::Stat::ListenersInsert);
+            instance->tableListeners[table].doInsert(count);
+        }
+
+        if (instance->segments) {
+            instance->segments->markDirty(table);
+        }
+
+        return DDS_RESULT_SUCCESS;
+    }
+
+    // inserts buffers holding all columns of the table in column order
+    DdsResult insertColumns(DdsInstance instance, DdsId table, DdsSize count,
+            std::vector<std::vector<uint8_t>> const &columns) {
+        if (count == 0) {
+            return DDS_RESULT_SUCCESS;
+        }
+
+        auto &data = *instance->info.data;
+        std::vector<DdsDataType> types;
+        std::vector<DdsData> columnData;
+        for (size_t i = 0; i != columns.size(); ++i) {
+            types.push_back(data.columns.type[instance->components.tableColumns[table][i]]);
+            columnData.push_back({columns[i].data(), columns[i].size()});
+        }
+        return ddsInsert(instance, table, count, types.size(), types.data(), columnData.data());
+    }
+
+    DdsResult replayRecord(DdsInstance instance, dds::WalRecordType type,
+            dds::WalDecoder &record) {
+        switch (type) {
+            case dds::WalRecordType::CreateTable: {
+                auto tableType = record.get<DdsTableType>();
+                std::string name = record.getString();
+                auto columnCount = record.get<DdsSize>();
+
+                std::vector<std::string> names;
+                std::vector<DdsDataType> types;
+                for (size_t i = 0; i != columnCount && record.valid(); ++i) {
+                    names.push_back(record.getString());
+                    types.push_back(record.get<DdsDataType>());
+                }
+                if (!record.valid()) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+
+                std::vector<char const *> pNames;
+                for (auto const &columnName : names) {
+                    pNames.push_back(columnName.c_str());
+                }
+
+                DdsId table;
+                return ddsCreateTable(instance, tableType, name.c_str(), columnCount,
+                        pNames.data(), types.data(), &table);
+            }
+            case dds::WalRecordType::DeleteTable:
+                return ddsDeleteTable(instance, record.get<DdsId>());
+            case dds::WalRecordType::Insert: {
+                auto table = record.get<DdsId>();
+                auto count = record.get<DdsSize>();
+                auto columnCount = record.get<DdsSize>();
+
+                std::vector<DdsDataType> types;
+                std::vector<DdsData> columnData;
+                for (size_t i = 0; i != columnCount && record.valid(); ++i) {
+                    types.push_back(record.get<DdsDataType>());
+                    columnData.push_back(record.getBytes());
+                }
+                if (!record.valid()) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+
+                return ddsInsert(instance, table, count, columnCount, types.data(),
+                        columnData.data());
+            }
+            case dds::WalRecordType::Remove: {
+                auto table = record.get<DdsId>();
+                auto position = record.get<DdsId>();
+                return ddsRemove(instance, table, position);
+            }
+            case dds::WalRecordType::RemoveRows: {
+                auto table = record.get<DdsId>();
+                auto count = record.get<DdsSize>();
+
+                // children were logged as rows of their own tables
+                std::vector<DdsId> rows;
+                for (size_t i = 0; i != count && record.valid(); ++i) {
+                    rows.push_back(record.get<DdsId>());
+                }
+                if (!record.valid()) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+                return removeTableRows(instance, table, rows);
+            }
+            case dds::WalRecordType::Update: {
+                auto column = record.get<DdsId>();
+                auto position = record.get<DdsId>();
+                auto dataType = record.get<DdsDataType>();
+                DdsData value = record.getBytes();
+                if (!record.valid() || !dds::checkValue(dataType, value)) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+                return updateValue(instance, column, position, value.pData);
+            }
+            case dds::WalRecordType::Sort: {
+                auto table = record.get<DdsId>();
+                auto order = record.get<DdsSortOrder>();
+                auto keyCount = record.get<DdsSize>();
+
+                std::vector<DdsId> keys;
+                for (size_t i = 0; i != keyCount && record.valid(); ++i) {
+                    keys.push_back(record.get<DdsId>());
+                }
+                if (!record.valid()) {
+                    return DDS_RESULT_INVALID_DATA;
+                }
+                return ddsSortTable(instance, table, keyCount, keys.data(), order);
+            }
+        }
+        return DDS_RESULT_INVALID_DATA;
+    }
+}
+
 DdsResult ddsCreateInstance(DdsInstanceCreateFlags flags, const char *file,
         DdsAllocator const* allocator, DdsInstance *pReturn) {
-    if (!fs::exists(file)) {
-        cista::buf buf{cista::mmap{file}};
-        dds::InstanceData tmp{};
-        cista::serialize(buf, tmp);
+    DDS_STAT_SCOPE(dds::Stat::CreateInstance);
+    if ((flags & DDS_INSTANCE_CREATE_WAL) && (flags & DDS_INSTANCE_CREATE_MMAP_READ)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+    if ((flags & DDS_INSTANCE_CREATE_LAZY) && !(flags & DDS_INSTANCE_CREATE_SEGMENTED)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+    // column buffers live either in mappings or in memory of the allocator
+    if (allocator && (flags & (DDS_INSTANCE_CREATE_MMAP_WRITE | DDS_INSTANCE_CREATE_MMAP_READ))) {
+        return DDS_RESULT_INVALID_DATA;
     }
 
-    auto serializeInfo = dds::makeSerializeInfo(flags, file);
-    auto components = dds::makeComponents(*serializeInfo.data);
+    dds::SerializeInfo serializeInfo;
+    dds::SegmentState segments;
+    std::unique_ptr<dds::MappedStore> store;
+    if (flags & DDS_INSTANCE_CREATE_SEGMENTED) {
+        if (flags & DDS_INSTANCE_CREATE_MMAP_WRITE) {
+            store = std::make_unique<dds::MappedStore>(file);
+        }
+
+        DdsResult result = dds::loadSegmented(file, serializeInfo, segments, store.get(),
+                flags & DDS_INSTANCE_CREATE_LAZY);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+    } else {
+        if (!fs::exists(file)) {
+            cista::buf buf{cista::mmap{file}};
+            dds::InstanceData tmp{};
+            cista::serialize(buf, tmp);
+        }
+        serializeInfo = dds::makeSerializeInfo(flags, file);
+    }
 
-    *pReturn = new DdsInstanceT{
+    dds::InstanceData &data = *serializeInfo.data;
+    auto instance = new DdsInstanceT{
             std::move(serializeInfo),
-            std::move(components),
+            dds::InstanceHelpers(data),
     };
 
+    instance->indexPool = std::make_unique<dds::SizeClassPool>(
+            allocator ? *allocator : DdsAllocator{});
+
+    if (allocator) {
+        instance->arenas = std::make_unique<dds::ArenaStore>(*allocator);
+        auto pArenas = instance->arenas.get();
+        pArenas->onTablesInsert(instance->info.data->tables.name.size());
+        instance->components.tables.onInsert([pArenas](size_t count) {
+            pArenas->onTablesInsert(count);
+        });
+        instance->components.tables.onRemove([pArenas](size_t table) {
+            pArenas->onTableRemove(table);
+        });
+
+        // loaded buffers move into the arenas right away, so every buffer is aligned
+        auto regions = dds::segmentRegions(*instance->info.data);
+        for (size_t table = 0; table != regions.size(); ++table) {
+            for (auto pBytes : regions[table]) {
+                DdsResult result = pArenas->reserve(*pBytes, table, pBytes->size());
+                if (result != DDS_RESULT_SUCCESS) {
+                    delete instance;
+                    return result;
+                }
+            }
+        }
+    }
+
+    if (flags & DDS_INSTANCE_CREATE_SEGMENTED) {
+        instance->store = std::move(store);
+        instance->segments = std::make_unique<dds::SegmentState>(std::move(segments));
+        auto pSegments = instance->segments.get();
+        instance->components.tables.onInsert([pSegments](size_t count) {
+            pSegments->onTablesInsert(count);
+        });
+        instance->components.tables.onRemove([pSegments](size_t table) {
+            pSegments->onTableRemove(table);
+        });
+    }
+
+    if (flags & DDS_INSTANCE_CREATE_WAL) {
+        std::string logPath = dds::walPath(instance->info.path);
+        uint64_t lastLsn = 0;
+
+        // the log is attached after replay so replayed changes are not logged again
+        DdsResult result = dds::replayWal(logPath, instance->info.data->walLsn, &lastLsn,
+                [instance](dds::WalRecordType type, dds::WalDecoder &record) {
+                    return replayRecord(instance, type, record);
+                });
+
+        if (result == DDS_RESULT_SUCCESS) {
+            instance->wal = std::make_shared<dds::WalWriter>(logPath, lastLsn);
+            if (!instance->wal->isOpen()) {
+                result = DDS_RESULT_IO_ERROR;
+            }
+        }
+
+        if (result != DDS_RESULT_SUCCESS) {
+            delete instance;
+            return result;
+        }
+    }
+
+    *pReturn = instance;
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsDeleteInstance(DdsInstance instance) {
+    DDS_STAT_SCOPE(dds::Stat::DeleteInstance);
     delete instance;
     return DDS_RESULT_SUCCESS;
 }
 
-DdsResult ddsSerialize(DdsInstance instance, DdsSerializeFlags) {
-    cista::buf b{cista::mmap{instance->info.path.c_str(), cista::mmap::protection::WRITE}};
-    cista::serialize(b, *instance->info.data);
+DdsResult ddsSerialize(DdsInstance instance, DdsSerializeFlags flags) {
+    DDS_STAT_SCOPE(dds::Stat::Serialize);
+    auto &data = *instance->info.data;
+    if (instance->wal) {
+        data.walLsn = instance->wal->lastLsn();
+    }
+
+    // a crash never leaves a half written snapshot that the log can not be replayed on
+    DdsResult result;
+    if (instance->store) {
+        result = instance->store->checkpoint(data, *instance->segments);
+    } else if (instance->segments) {
+        result = dds::writeCheckpoint(data, instance->info.path, *instance->segments,
+                flags & DDS_SERIALIZE_FULL);
+    } else {
+        result = dds::serializeAtomic(instance->info.path, data);
+    }
+
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    if (instance->wal) {
+        return instance->wal->truncate(data.walLsn);
+    }
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsSerializeAsync(DdsInstance instance, DdsSerializeFlags flags,
+        DdsSerializeJob *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::SerializeAsync);
+    (void) flags; // only segmented instances write incrementally, and they are not supported
+    if (instance->segments) {
+        return DDS_RESULT_NOT_SUPPORTED;
+    }
+
+    auto &data = *instance->info.data;
+    if (instance->wal) {
+        data.walLsn = instance->wal->lastLsn();
+    }
+
+    // the job owns its copy and a reference to the log, so it may outlive the instance
+    uint64_t lsn = data.walLsn;
+    std::shared_ptr<dds::WalWriter> pWal = instance->wal;
+    *pReturn = new DdsSerializeJobT{{
+            instance->info.path,
+            std::make_unique<dds::InstanceData>(data),
+            [pWal = std::move(pWal), lsn] {
+                return pWal ? pWal->truncate(lsn) : DDS_RESULT_SUCCESS;
+            },
+    }};
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsPollSerialize(DdsSerializeJob job) {
+    DDS_STAT_SCOPE(dds::Stat::PollSerialize);
+    return job->job.poll();
+}
+
+DdsResult ddsWaitSerialize(DdsSerializeJob job) {
+    DDS_STAT_SCOPE(dds::Stat::WaitSerialize);
+    return job->job.wait();
+}
+
+DdsResult ddsDeleteSerializeJob(DdsSerializeJob job) {
+    DDS_STAT_SCOPE(dds::Stat::DeleteSerializeJob);
+    delete job;
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsCreateTable(DdsInstance instance, DdsTableType type, char const *name,
         DdsSize columnCount, char const *const *pColumnNames, DdsDataType const *pColumnTypes,
         DdsId *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::CreateTable);
     auto &data = *instance->info.data;
     auto &components = instance->components;
     if (components.tableNameIndex[name]) {
@@ -80,32 +746,80 @@ DdsResult ddsCreateTable(DdsInstance instance, DdsTableType type, char const *na
         }
     }
 
+    if (instance->wal) {
+        dds::WalEncoder record;
+        record.put(type).putString(name).put(columnCount);
+        for (size_t i = 0; i != columnCount; ++i) {
+            record.putString(pColumnNames[i]).put(pColumnTypes[i]);
+        }
+        result = instance->wal->append(dds::WalRecordType::CreateTable, record);
+        if (result != DDS_RESULT_SUCCESS) {
+            components.tables.remove(table);
+            return result;
+        }
+    }
+
     *pReturn = table;
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsDeleteTable(DdsInstance instance, DdsId tableId) {
+    DDS_STAT_SCOPE(dds::Stat::DeleteTable);
     auto &components = instance->components;
+    if (instance->wal) {
+        dds::WalEncoder record;
+        record.put(tableId);
+        DdsResult result = instance->wal->append(dds::WalRecordType::DeleteTable, record);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+    }
+
     components.tables.remove(tableId);
     return DDS_RESULT_SUCCESS;
 }
 
+DdsResult ddsPrefetchTable(DdsInstance instance, DdsId table, DdsAccessHint hint) {
+    DDS_STAT_SCOPE(dds::Stat::PrefetchTable);
+    if (!instance->segments) {
+        return DDS_RESULT_SUCCESS;
+    }
+    return dds::adviseTable(*instance->info.data, instance->info.path, *instance->segments, table,
+            hint);
+}
+
 DdsResult ddsFind(DdsInstance instance, DdsId column, DdsDataType type, void const *pValue,
         DdsId *pResult) {
+    DDS_STAT_SCOPE(dds::Stat::Find);
     auto &data = *instance->info.data;
     auto &components = instance->components;
 
+    DdsResult result = ensureLoaded(instance, data.columns.table[column]);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
     auto f = [column, instance, pResult, &components, &data](auto &map, auto value) {
         using value_type = std::decay_t<decltype(value)>;
 
         auto iter = map.find(column);
         if (iter == map.end()) {
+            DDS_STAT_SCOPE(dds::Stat::IndexBuild);
             auto &tableListener = instance->tableListeners[data.columns.table[column]];
-            dds::getRange<value_type>(data, components, column,
-                    [&tableListener, &iter, &map, column](auto range) {
-                        dds::IdMap<value_type> idMap(tableListener, range);
-                        return map.emplace(column, std::move(idMap)).first;
-                    });
+            auto build = [&tableListener, &iter, &map, column, instance](auto range) {
+                auto pRange = std::make_shared<decltype(range)>(range);
+                instance->columnViews.push_back(pRange);
+                // built in place, its callbacks capture its address
+                iter = map.try_emplace(column, tableListener, *pRange,
+                        instance->indexPool.get()).first;
+                return DDS_RESULT_SUCCESS;
+            };
+            // string keys are copied out of the heap, which moves on growth and compaction
+            if constexpr (std::is_same_v<value_type, std::string>) {
+                build(dds::StringColumn(components, data, column));
+            } else {
+                dds::getRange<value_type>(data, components, column, build);
+            }
         }
 
         if (auto val = (iter->second)[value]) {
@@ -121,23 +835,52 @@ DdsResult ddsFind(DdsInstance instance, DdsId column, DdsDataType type, void con
 
 DdsResult ddsMakeConnection(DdsInstance instance, DdsId parentTable, DdsId childParentColumn,
         DdsConnectionType type) {
+    DDS_STAT_SCOPE(dds::Stat::MakeConnection);
     auto &data = *instance->info.data;
     auto &components = instance->components;
 
     DdsDataType dataType = data.columns.type[childParentColumn];
 
+    DdsResult result = ensureLoaded(instance, parentTable);
+    if (result == DDS_RESULT_SUCCESS) {
+        result = ensureLoaded(instance, data.columns.table[childParentColumn]);
+    }
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    // removing a parent removes its children, which has to come to an end
+    DdsId childTable = data.columns.table[childParentColumn];
+    if (reachesTable(instance, childTable, parentTable)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
     auto &parentComponent = instance->tableListeners[parentTable];
-    auto &childComponent = instance->tableListeners[data.columns.table[childParentColumn]];
+    auto &childComponent = instance->tableListeners[childTable];
+    DdsSize parentCount = dds::rowCount(components, data, parentTable);
 
-    return dds::getTypeRange(data, dataType, components, childParentColumn,
-            [childParentColumn, instance, type, &childComponent, &parentComponent](auto range) {
+    result = dds::getTypeRange(data, dataType, components, childParentColumn,
+            [childParentColumn, instance, type, parentCount, &childComponent,
+                    &parentComponent](auto range) {
+                for (size_t i = 0; i != range.size(); ++i) {
+                    if (static_cast<uint64_t>(range[i]) >= parentCount) {
+                        return DDS_RESULT_INVALID_DATA;
+                    }
+                }
+                auto pRange = std::make_shared<decltype(range)>(range);
+                instance->columnViews.push_back(pRange);
                 return dds::insertConnection(instance->connections, childParentColumn, type,
-                        childComponent, range, parentComponent);
+                        childComponent, *pRange, parentComponent, parentCount);
             });
+    if (result == DDS_RESULT_SUCCESS) {
+        instance->connections.parents[childParentColumn] = parentTable;
+    }
+    return result;
 }
 
 DdsResult ddsFindChild(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
         DdsId *pResult) {
+    DDS_STAT_SCOPE(dds::Stat::FindChild);
     auto &connections = instance->connections.single;
     auto iter = connections.find(childParentColumn);
     if (iter == connections.end()) {
@@ -153,28 +896,100 @@ DdsResult ddsFindChild(DdsInstance instance, DdsId childParentColumn, DdsId pare
 }
 
 DdsResult ddsFindChildren(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
-        DdsId const **pResult, DdsSize *pChildrenCount) {
+        DdsRowIndex const **pResult, DdsSize *pChildrenCount) {
+    DDS_STAT_SCOPE(dds::Stat::FindChildren);
     auto &connections = instance->connections.multi;
     auto iter = connections.find(childParentColumn);
     if (iter == connections.end()) {
         return DDS_RESULT_NOT_CONNECTED;
     }
 
-    if (pResult == nullptr) {
-        *pChildrenCount = iter->second[parentId].size();
-    } else {
-        *pResult = iter->second[parentId].data();
+    auto children = iter->second[parentId];
+    *pChildrenCount = children.size();
+    if (pResult != nullptr) {
+        *pResult = children.data();
     }
 
     return DDS_RESULT_SUCCESS;
 }
 
+namespace {
+    // sorts the child table of a cluster again if it changed since it was last sorted
+    DdsResult sortCluster(DdsInstance instance, DdsId childParentColumn, bool &unsorted) {
+        if (!unsorted) {
+            return DDS_RESULT_SUCCESS;
+        }
+        DdsId table = instance->info.data->columns.table[childParentColumn];
+        DdsResult result = ddsSortTable(instance, table, 1, &childParentColumn,
+                DDS_SORT_ASCENDING);
+        if (result == DDS_RESULT_SUCCESS) {
+            unsorted = false;
+        }
+        return result;
+    }
+}
+
+DdsResult ddsClusterChildren(DdsInstance instance, DdsId parentTable, DdsId childParentColumn) {
+    DDS_STAT_SCOPE(dds::Stat::ClusterChildren);
+    auto &connections = instance->connections;
+    if (!connections.single.count(childParentColumn) &&
+            !connections.multi.count(childParentColumn)) {
+        return DDS_RESULT_NOT_CONNECTED;
+    }
+    if (connections.parents[childParentColumn] != parentTable) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    auto [iter, inserted] = instance->clusters.try_emplace(childParentColumn, true);
+    bool &unsorted = iter->second;
+    if (inserted) {
+        auto markUnsorted = [&unsorted](auto const &) {
+            unsorted = true;
+        };
+
+        DdsId childTable = instance->info.data->columns.table[childParentColumn];
+        auto &childListener = instance->tableListeners[childTable];
+        childListener.onInsert(markUnsorted);
+        childListener.onRemove(markUnsorted);
+        childListener.onPermute(markUnsorted);
+
+        // removes and sorts renumber the parents of children
+        auto &parentListener = instance->tableListeners[parentTable];
+        parentListener.onRemove(markUnsorted);
+        parentListener.onPermute(markUnsorted);
+    }
+    return sortCluster(instance, childParentColumn, unsorted);
+}
+
+DdsResult ddsFindChildRange(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
+        DdsId *pOffset, DdsSize *pCount) {
+    DDS_STAT_SCOPE(dds::Stat::FindChildRange);
+    auto &data = *instance->info.data;
+    auto iter = instance->clusters.find(childParentColumn);
+    if (iter == instance->clusters.end()) {
+        return DDS_RESULT_NOT_CONNECTED;
+    }
+    if (iter->second) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    DdsDataType type = data.columns.type[childParentColumn];
+    DdsColumnData column;
+    DdsResult result = ddsColumnData(instance, childParentColumn, type, &column);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+    return dds::childRange(column, type, parentId, pOffset, pCount);
+}
+
 DdsResult ddsGetTablesCount(DdsInstance instance, DdsSize *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetTablesCount);
     *pReturn = instance->info.data->tables.name.size();
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsGetTable(DdsInstance instance, char const *name, DdsId *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetTable);
     if (auto id = instance->components.tableNameIndex[name]) {
         *pReturn = *id;
         return DDS_RESULT_SUCCESS;
@@ -184,26 +999,35 @@ DdsResult ddsGetTable(DdsInstance instance, char const *name, DdsId *pReturn) {
 }
 
 DdsResult ddsGetTableName(DdsInstance instance, DdsId table, char const **pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetTableName);
     *pReturn = instance->info.data->tables.name[table].data();
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsGetTableLength(DdsInstance instance, DdsId table, DdsSize *pReturn) {
-    *pReturn = instance->info.data->tables.length[table];
+    DDS_STAT_SCOPE(dds::Stat::GetTableLength);
+    // tables.length is never kept up to date, the rows are counted from the column data
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+    *pReturn = dds::rowCount(instance->components, *instance->info.data, table);
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsGetTableColumns(DdsInstance instance, DdsId table, DdsId const **pReturn,
         DdsSize *pColumnCount) {
-    if (pReturn == nullptr) {
-        *pColumnCount = instance->components.tableColumns[table].size();
-    } else {
-        *pReturn = instance->components.tableColumns[table].data();
+    DDS_STAT_SCOPE(dds::Stat::GetTableColumns);
+    auto const &columns = instance->components.tableColumns[table];
+    *pColumnCount = columns.size();
+    if (pReturn != nullptr) {
+        *pReturn = columns.data();
     }
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsGetColumn(DdsInstance instance, DdsId table, const char *name, DdsId *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetColumn);
     for (DdsSize column : instance->components.tableColumns[table]) {
         if (instance->info.data->columns.name[column] == name) {
             *pReturn = column;
@@ -214,17 +1038,31 @@ DdsResult ddsGetColumn(DdsInstance instance, DdsId table, const char *name, DdsI
 }
 
 DdsResult ddsGetColumnName(DdsInstance instance, DdsId column, char const **pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetColumnName);
     *pReturn = instance->info.data->columns.name[column].data();
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsGetColumnType(DdsInstance instance, DdsId column, DdsDataType *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetColumnType);
     *pReturn = instance->info.data->columns.type[column];
     return DDS_RESULT_SUCCESS;
 }
 
+DdsResult ddsGetColumnOffset(DdsInstance instance, DdsId column, DdsSize *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::GetColumnOffset);
+    auto &data = *instance->info.data;
+    if (!instance->components.tableAosData[data.columns.table[column]]) {
+        return DDS_RESULT_TABLE_NOT_EXIST;
+    }
+
+    *pReturn = data.columns.aosColumnOffset[column];
+    return DDS_RESULT_SUCCESS;
+}
+
 DdsResult ddsInsert(DdsInstance instance, DdsId table, DdsSize count, DdsSize columnCount,
         DdsDataType const *pColumnTypes, DdsData const *pColumnData) {
+    DDS_STAT_SCOPE(dds::Stat::Insert);
     auto &data = *instance->info.data;
     auto &components = instance->components;
 
@@ -237,33 +1075,245 @@ DdsResult ddsInsert(DdsInstance instance, DdsId table, DdsSize count, DdsSize co
         return result;
     }
 
-    if (auto aosId = components.tableAosData[table]) {
-        dds::aosInsert(components, data, table, *aosId, count, pColumnData);
-    } else {
-        dds::soaInsert(components, data, table, pColumnData);
+    result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    if (count >= dds::maxIndexedRows - dds::rowCount(components, data, table)) {
+        return DDS_RESULT_OUT_OF_MEMORY;
+    }
+
+    return appendColumns(instance, table, count, columnCount, pColumnTypes, pColumnData);
+}
+
+DdsResult ddsInsertRows(DdsInstance instance, DdsId table, DdsSize count, DdsData rows) {
+    DDS_STAT_SCOPE(dds::Stat::InsertRows);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+
+    auto aosId = components.tableAosData[table];
+    if (!aosId) {
+        return DDS_RESULT_TABLE_NOT_EXIST;
+    }
+    // cells of strings point into the heaps, so their values have to go through ddsInsert
+    if (dds::hasStrings(components, data, table)) {
+        return DDS_RESULT_INVALID_TYPE;
+    }
+    DdsSize rowSize = data.aosTables.rowSize[*aosId];
+    if (rows.size != count * rowSize) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    // log records hold columns, so split the rows for the log and replay
+    if (instance->wal) {
+        auto const &columns = components.tableColumns[table];
+        std::vector<DdsDataType> types;
+        std::vector<std::vector<uint8_t>> columnBytes;
+        std::vector<DdsData> columnData;
+        for (DdsId column : columns) {
+            DdsDataType type = data.columns.type[column];
+            DdsSize typeSize = dds::sizeOfType(type);
+            DdsSize offset = data.columns.aosColumnOffset[column];
+
+            auto &bytes = columnBytes.emplace_back(count * typeSize);
+            for (size_t i = 0; i != count; ++i) {
+                auto beg = rows.pData + i * rowSize + offset;
+                std::copy(beg, beg + typeSize, bytes.begin() + i * typeSize);
+            }
+            types.push_back(type);
+        }
+        for (auto const &bytes : columnBytes) {
+            columnData.push_back({bytes.data(), bytes.size()});
+        }
+        return ddsInsert(instance, table, count, types.size(), types.data(), columnData.data());
+    }
+
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
     }
+    if (count >= dds::maxIndexedRows - dds::rowCount(components, data, table)) {
+        return DDS_RESULT_OUT_OF_MEMORY;
+    }
+
+    result = reserveRows(instance, table, count);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    dds::aosAppend(data, *aosId, rows);
 
-    instance->tableListeners[table].doInsert(count);
+    {
+        DDS_STAT_SCOPE(dds::Stat::ListenersInsert);
+        instance->tableListeners[table].doInsert(count);
+    }
 
+    if (instance->segments) {
+        instance->segments->markDirty(table);
+    }
     return DDS_RESULT_SUCCESS;
 }
 
+DdsResult ddsImport(DdsInstance instance, DdsId table, DdsImportFormat format, char const *path,
+        DdsImportOptions const *pOptions) {
+    DDS_STAT_SCOPE(dds::Stat::Import);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+    DdsImportOptions options = pOptions ? *pOptions : DdsImportOptions{};
+
+    auto const &tableColumns = components.tableColumns[table];
+    std::vector<DdsDataType> types;
+    for (DdsId column : tableColumns) {
+        types.push_back(data.columns.type[column]);
+    }
+
+    std::vector<size_t> fileColumns;
+    if (options.columnCount == 0) {
+        for (size_t i = 0; i != types.size(); ++i) {
+            fileColumns.push_back(i);
+        }
+    }
+    for (size_t i = 0; i != options.columnCount; ++i) {
+        auto iter = std::find(tableColumns.begin(), tableColumns.end(), options.pColumns[i]);
+        if (iter == tableColumns.end()) {
+            return DDS_RESULT_COLUMN_NOT_EXIST;
+        }
+        fileColumns.push_back(static_cast<size_t>(iter - tableColumns.begin()));
+    }
+
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    std::vector<std::vector<uint8_t>> columns;
+    DdsSize count = 0;
+    result = dds::importFile(format, path, options, types, fileColumns, columns, count);
+    if (result != DDS_RESULT_SUCCESS || count == 0) {
+        return result;
+    }
+    if (count >= dds::maxIndexedRows - dds::rowCount(components, data, table)) {
+        return DDS_RESULT_OUT_OF_MEMORY;
+    }
+
+    // the parsed buffers have the sizes of the column types and no variable length strings,
+    // so they skip the checks of ddsInsert
+    std::vector<DdsData> columnData;
+    for (auto const &column : columns) {
+        columnData.push_back({column.data(), column.size()});
+    }
+    return appendColumns(instance, table, count, types.size(), types.data(), columnData.data());
+}
+
+DdsResult ddsExportArrow(DdsInstance instance, DdsId table, ArrowSchema *pSchema,
+        ArrowArray *pArray) {
+    DDS_STAT_SCOPE(dds::Stat::ExportArrow);
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+    return dds::exportArrow(*instance->info.data, instance->components, table, pSchema, pArray);
+}
+
+DdsResult ddsImportArrow(DdsInstance instance, DdsId table, ArrowSchema *pSchema,
+        ArrowArray *pArray) {
+    DDS_STAT_SCOPE(dds::Stat::ImportArrow);
+    std::vector<std::vector<uint8_t>> columns;
+    DdsSize count = 0;
+    DdsResult result = dds::importArrow(*instance->info.data, instance->components, table,
+            *pSchema, *pArray, columns, count);
+    pArray->release(pArray);
+    pSchema->release(pSchema);
+
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+    return insertColumns(instance, table, count, columns);
+}
+
 DdsResult ddsRemove(DdsInstance instance, DdsId table, DdsId position) {
+    DDS_STAT_SCOPE(dds::Stat::Remove);
     auto &data = *instance->info.data;
     auto &components = instance->components;
 
-    instance->tableListeners[table].doRemove(position);
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
 
-    if (auto aosId = components.tableAosData[table]) {
-        dds::aosRemove(data, *aosId, position);
-    } else {
-        dds::soaRemove(components, data, table, position);
+    if (position >= dds::rowCount(components, data, table)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+    return removeCascade(instance, {{table, {position}}});
+}
+
+DdsResult ddsRemoveRows(DdsInstance instance, DdsId table, DdsSize count,
+        DdsId const *pPositions) {
+    DDS_STAT_SCOPE(dds::Stat::RemoveRows);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    DdsSize rows = dds::rowCount(components, data, table);
+    for (size_t i = 0; i != count; ++i) {
+        if (pPositions[i] >= rows) {
+            return DDS_RESULT_INVALID_DATA;
+        }
+    }
+    return removeCascade(instance, {{table, std::vector<DdsId>(pPositions, pPositions + count)}});
+}
+
+DdsResult ddsSortTable(DdsInstance instance, DdsId table, DdsSize keyCount,
+        DdsId const *pKeyColumns, DdsSortOrder order) {
+    DDS_STAT_SCOPE(dds::Stat::SortTable);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    std::vector<size_t> rows;
+    result = dds::sortOrder(components, data, table, keyCount, pKeyColumns, order, rows);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    // the sort is stable, so replay reproduces the order from the keys alone
+    if (instance->wal) {
+        dds::WalEncoder record;
+        record.put(table).put(order).put(keyCount);
+        for (size_t i = 0; i != keyCount; ++i) {
+            record.put(pKeyColumns[i]);
+        }
+        result = instance->wal->append(dds::WalRecordType::Sort, record);
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+    }
+
+    dds::permuteRows(components, data, table, rows);
+
+    {
+        DDS_STAT_SCOPE(dds::Stat::ListenersPermute);
+        instance->tableListeners[table].doPermute(rows);
+    }
+
+    if (instance->segments) {
+        instance->segments->markDirty(table);
     }
     return DDS_RESULT_SUCCESS;
 }
 
 DdsResult ddsColumnData(DdsInstance instance, DdsId column, DdsDataType type,
         DdsColumnData *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::ColumnData);
     auto &data = *instance->info.data;
     auto &components = instance->components;
     if (data.columns.type[column] != type) {
@@ -272,6 +1322,11 @@ DdsResult ddsColumnData(DdsInstance instance, DdsId column, DdsDataType type,
 
     DdsId table = data.columns.table[column];
 
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
     if (auto aosId = components.tableAosData[table]) {
         *pReturn = dds::aosColumnData(data, *aosId, column);
     } else {
@@ -282,11 +1337,17 @@ DdsResult ddsColumnData(DdsInstance instance, DdsId column, DdsDataType type,
 }
 
 DdsResult ddsAosData(DdsInstance instance, DdsId column, DdsData *pResult) {
+    DDS_STAT_SCOPE(dds::Stat::AosData);
     auto &data = *instance->info.data;
     auto &components = instance->components;
 
     DdsId table = data.columns.table[column];
 
+    DdsResult result = ensureLoaded(instance, table);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
     if (auto aosId = components.tableAosData[table]) {
         auto &bytes = data.aosTables.data[*aosId];
         *pResult = DdsData{
@@ -298,3 +1359,422 @@ DdsResult ddsAosData(DdsInstance instance, DdsId column, DdsData *pResult) {
         return DDS_RESULT_TABLE_NOT_EXIST;
     }
 }
+
+DdsResult ddsStringHeap(DdsInstance instance, DdsId column, DdsData *pResult) {
+    DDS_STAT_SCOPE(dds::Stat::StringHeap);
+    auto &data = *instance->info.data;
+    if (data.columns.type[column] != DDS_STRING_TYPE) {
+        return DDS_RESULT_INVALID_TYPE;
+    }
+
+    DdsResult result = ensureLoaded(instance, data.columns.table[column]);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    auto &chars = data.columns.stringHeap[column].chars;
+    *pResult = DdsData{
+            chars.begin(),
+            chars.size(),
+    };
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsGetMemoryStats(DdsInstance instance, DdsMemoryTotals *pTotals,
+        DdsMemoryStats *pEntries, DdsSize *pEntryCount) {
+    DDS_STAT_SCOPE(dds::Stat::GetMemoryStats);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+
+    std::vector<DdsMemoryStats> entries;
+    auto add = [&entries](DdsMemoryKind kind, DdsId id, dds::MemoryUsage usage) {
+        entries.push_back({kind, id, usage.used, usage.reserved});
+    };
+    auto dataUsage = [](auto const &vector) {
+        using T = typename std::decay_t<decltype(vector)>::value_type;
+        return dds::MemoryUsage{vector.size() * sizeof(T), vector.allocated_size_ * sizeof(T)};
+    };
+
+    // live buffer capacity per table, what its arena holds beyond that is fragmentation
+    std::vector<size_t> tableBuffers(data.tables.name.size());
+    for (DdsId column = 0; column != data.columns.table.size(); ++column) {
+        bool soa = !components.tableAosData[data.columns.table[column]];
+        bool strings = data.columns.type[column] == DDS_STRING_TYPE;
+        if (!soa && !strings) {
+            continue;
+        }
+
+        dds::MemoryUsage usage{};
+        if (soa) {
+            usage = dataUsage(data.columns.soaColumnData[column]);
+            tableBuffers[data.columns.table[column]] += usage.reserved;
+        }
+        if (strings) {
+            usage += dataUsage(data.columns.stringHeap[column].chars);
+        }
+        add(DDS_MEMORY_COLUMN, column, usage);
+    }
+    for (size_t aosId = 0; aosId != data.aosTables.table.size(); ++aosId) {
+        auto usage = dataUsage(data.aosTables.data[aosId]);
+        tableBuffers[data.aosTables.table[aosId]] += usage.reserved;
+        add(DDS_MEMORY_AOS_TABLE, data.aosTables.table[aosId], usage);
+    }
+
+    instance->idMaps.forEach([&add](DdsId column, auto const &idMap) {
+        add(DDS_MEMORY_ID_MAP, column, idMap.memoryUsage());
+    });
+    for (auto const &[column, connection] : instance->connections.single) {
+        add(DDS_MEMORY_CONNECTION, column, connection.memoryUsage());
+    }
+    for (auto const &[column, connection] : instance->connections.multi) {
+        add(DDS_MEMORY_MULTI_CONNECTION, column, connection.memoryUsage());
+    }
+    for (auto const &[table, listener] : instance->tableListeners) {
+        add(DDS_MEMORY_LISTENER, table, listener.memoryUsage());
+    }
+
+    dds::MemoryUsage catalog = dataUsage(data.tables.name);
+    catalog += dataUsage(data.tables.length);
+    catalog += dataUsage(data.columns.name);
+    catalog += dataUsage(data.columns.type);
+    catalog += dataUsage(data.columns.table);
+    catalog += dataUsage(data.columns.aosColumnOffset);
+    catalog += dataUsage(data.aosTables.table);
+    catalog += dataUsage(data.aosTables.rowSize);
+    catalog += components.tableNameIndex.memoryUsage();
+    catalog += components.tableColumns.memoryUsage();
+    catalog += components.tableAosData.memoryUsage();
+    add(DDS_MEMORY_CATALOG, 0, catalog);
+
+    if (pTotals) {
+        *pTotals = {};
+        for (auto const &entry : entries) {
+            pTotals->usedBytes += entry.usedBytes;
+            pTotals->reservedBytes += entry.reservedBytes;
+        }
+        pTotals->slackBytes = pTotals->reservedBytes - pTotals->usedBytes;
+
+        auto &pool = *instance->indexPool;
+        pTotals->allocatorBytes = pool.reservedBytes();
+        pTotals->fragmentationBytes = pool.reservedBytes() - pool.usedBytes();
+        if (instance->arenas) {
+            for (DdsId table = 0; table != tableBuffers.size(); ++table) {
+                size_t reserved = instance->arenas->arena(table).reservedBytes();
+                pTotals->allocatorBytes += reserved;
+                pTotals->fragmentationBytes += reserved - std::min(reserved, tableBuffers[table]);
+            }
+        }
+    }
+
+    if (pEntries == nullptr) {
+        *pEntryCount = entries.size();
+    } else {
+        *pEntryCount = std::min<DdsSize>(*pEntryCount, entries.size());
+        std::copy(entries.begin(), entries.begin() + *pEntryCount, pEntries);
+    }
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsRecordInsert(DdsInstance instance, DdsId table, DdsId sortKey, DdsSize count,
+        DdsSize columnCount, DdsDataType const *pColumnTypes, DdsData const *pColumnData) {
+    DDS_STAT_SCOPE(dds::Stat::RecordInsert);
+    auto &data = *instance->info.data;
+    auto &components = instance->components;
+
+    if (components.tableColumns[table].size() != columnCount) {
+        return DDS_RESULT_INVALID_TYPE;
+    }
+
+    DdsResult result = dds::checkColumns(data, components, table, count, pColumnTypes, pColumnData);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    auto &buffer = instance->commands.local();
+    dds::Command command{dds::CommandType::Insert, table, sortKey, 0, count, buffer.arena.size(), 0};
+    for (size_t i = 0; i != columnCount; ++i) {
+        buffer.push(pColumnData[i].pData, pColumnData[i].size);
+    }
+    command.dataSize = buffer.arena.size() - command.dataOffset;
+    buffer.commands.push_back(command);
+
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsRecordRemove(DdsInstance instance, DdsId table, DdsId sortKey, DdsId position) {
+    DDS_STAT_SCOPE(dds::Stat::RecordRemove);
+    if (!recordedRowExists(instance, table, position)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    auto &buffer = instance->commands.local();
+    buffer.commands.push_back({dds::CommandType::Remove, table, sortKey, position, 0, 0, 0});
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsRecordUpdate(DdsInstance instance, DdsId column, DdsId sortKey, DdsId position,
+        DdsDataType type, void const *pValue) {
+    DDS_STAT_SCOPE(dds::Stat::RecordUpdate);
+    auto &data = *instance->info.data;
+    auto &connections = instance->connections;
+
+    if (data.columns.type[column] != type) {
+        return DDS_RESULT_INVALID_TYPE;
+    }
+
+    if (connections.single.count(column) || connections.multi.count(column)) {
+        return DDS_RESULT_ALREADY_CONNECTED;
+    }
+
+    if (!recordedRowExists(instance, data.columns.table[column], position)) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    auto valueBytes = static_cast<uint8_t const *>(pValue);
+    DdsSize size = dds::valuesSize(type, 1, valueBytes);
+    if (!dds::checkValue(type, {valueBytes, size})) {
+        return DDS_RESULT_INVALID_DATA;
+    }
+
+    auto &buffer = instance->commands.local();
+    DdsSize offset = buffer.push(pValue, size);
+    buffer.commands.push_back({dds::CommandType::Update, column, sortKey, position, 1, offset, size});
+
+    return DDS_RESULT_SUCCESS;
+}
+
+namespace {
+    // Updates and removes are checked before anything is applied
+    DdsResult applyCommands(DdsInstance instance) {
+        auto &data = *instance->info.data;
+        auto &components = instance->components;
+
+        std::unordered_map<DdsId, std::vector<DdsId>> removes;
+        std::map<DdsId, std::vector<dds::CommandRef>> inserts;
+
+        // positions refer to rows before the flush, tables may have shrunk since they were recorded
+        auto commands = dds::collectCommands(instance->commands);
+        DdsResult result = DDS_RESULT_SUCCESS;
+        for (auto const &ref : commands) {
+            if (ref.command->type == dds::CommandType::Insert) {
+                continue;
+            }
+            DdsId table = ref.command->type == dds::CommandType::Update ?
+                    data.columns.table[ref.command->target] : ref.command->target;
+            result = ensureLoaded(instance, table);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+            if (ref.command->position >= dds::rowCount(components, data, table)) {
+                return DDS_RESULT_INVALID_DATA;
+            }
+        }
+
+        for (auto const &ref : commands) {
+            switch (ref.command->type) {
+                case dds::CommandType::Update:
+                    result = updateValue(instance, ref.command->target, ref.command->position,
+                            ref.data());
+                    if (result != DDS_RESULT_SUCCESS) {
+                        return result;
+                    }
+                    break;
+                case dds::CommandType::Remove:
+                    removes[ref.command->target].push_back(ref.command->position);
+                    break;
+                case dds::CommandType::Insert:
+                    inserts[ref.command->target].push_back(ref);
+                    break;
+            }
+        }
+
+        // one cascade over all tables, so positions recorded in a child table are not moved by
+        // the removal of its parents first
+        if (!removes.empty()) {
+            result = removeCascade(instance, std::move(removes));
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        for (auto const &[table, refs] : inserts) {
+            auto const &columns = components.tableColumns[table];
+
+            DdsSize count = 0;
+            for (auto const &ref : refs) {
+                count += ref.command->count;
+            }
+
+            std::vector<DdsDataType> types(columns.size());
+            std::vector<std::vector<uint8_t>> bytes(columns.size());
+            std::vector<DdsData> columnData(columns.size());
+
+            // columns of a single recorded insert are stored back to back, string values of all
+            // inserts are merged into one buffer
+            std::vector<DdsSize> offsets(refs.size());
+            for (size_t i = 0; i != columns.size(); ++i) {
+                types[i] = data.columns.type[columns[i]];
+                dds::StringValues strings;
+
+                if (types[i] != DDS_STRING_TYPE) {
+                    bytes[i].reserve(count * dds::sizeOfType(types[i]));
+                }
+                for (size_t j = 0; j != refs.size(); ++j) {
+                    auto beg = refs[j].data() + offsets[j];
+                    DdsSize size = dds::valuesSize(types[i], refs[j].command->count, beg);
+                    if (types[i] == DDS_STRING_TYPE) {
+                        strings.add(refs[j].command->count, beg);
+                    } else {
+                        bytes[i].insert(bytes[i].end(), beg, beg + size);
+                    }
+                    offsets[j] += size;
+                }
+                if (types[i] == DDS_STRING_TYPE) {
+                    bytes[i] = strings.bytes();
+                }
+                columnData[i] = DdsData{bytes[i].data(), bytes[i].size()};
+            }
+
+            result = ddsInsert(instance, table, count, columns.size(), types.data(),
+                    columnData.data());
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+
+        return DDS_RESULT_SUCCESS;
+    }
+}
+
+DdsResult ddsFlushCommands(DdsInstance instance) {
+    DDS_STAT_SCOPE(dds::Stat::FlushCommands);
+    return logBatch(instance, [instance] {
+        // commands applied before a failure can not be applied again, so all of them are dropped
+        DdsResult result = applyCommands(instance);
+        instance->commands.forEach([](dds::CommandBuffer &buffer) {
+            buffer.clear();
+        });
+        if (result != DDS_RESULT_SUCCESS) {
+            return result;
+        }
+
+        // clusters changed by the batch are sorted once for all of its commands
+        for (auto &[column, unsorted] : instance->clusters) {
+            result = sortCluster(instance, column, unsorted);
+            if (result != DDS_RESULT_SUCCESS) {
+                return result;
+            }
+        }
+        return DDS_RESULT_SUCCESS;
+    });
+}
+
+DdsResult ddsRegisterComponent(DdsInstance instance, char const *name, DdsDataType type,
+        DdsId *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::RegisterComponent);
+    return archetypes(instance).registerComponent(name, type, pReturn);
+}
+
+DdsResult ddsCreateEntities(DdsInstance instance, DdsSize count, DdsSize componentCount,
+        DdsId const *pComponents, void const *const *pValues, DdsEntity *pReturn) {
+    DDS_STAT_SCOPE(dds::Stat::CreateEntities);
+    return logBatch(instance, [&] {
+        return archetypes(instance).createEntities(count, componentCount, pComponents, pValues,
+                pReturn);
+    });
+}
+
+DdsResult ddsDestroyEntities(DdsInstance instance, DdsSize count, DdsEntity const *pEntities) {
+    DDS_STAT_SCOPE(dds::Stat::DestroyEntities);
+    return logBatch(instance, [&] {
+        return archetypes(instance).destroyEntities(count, pEntities);
+    });
+}
+
+DdsResult ddsAddComponent(DdsInstance instance, DdsSize count, DdsEntity const *pEntities,
+        DdsId component, void const *pValues) {
+    DDS_STAT_SCOPE(dds::Stat::AddComponent);
+    return logBatch(instance, [&] {
+        return archetypes(instance).addComponent(count, pEntities, component, pValues);
+    });
+}
+
+DdsResult ddsRemoveComponent(DdsInstance instance, DdsSize count, DdsEntity const *pEntities,
+        DdsId component) {
+    DDS_STAT_SCOPE(dds::Stat::RemoveComponent);
+    return logBatch(instance, [&] {
+        return archetypes(instance).removeComponent(count, pEntities, component);
+    });
+}
+
+DdsResult ddsGetEntity(DdsInstance instance, DdsEntity entity, DdsId *pTable, DdsId *pRow) {
+    DDS_STAT_SCOPE(dds::Stat::GetEntity);
+    return archetypes(instance).locate(entity, pTable, pRow);
+}
+
+DdsResult ddsQueryArchetypes(DdsInstance instance, DdsSize componentCount,
+        DdsId const *pComponents, DdsId *pTables, DdsSize *pTableCount) {
+    DDS_STAT_SCOPE(dds::Stat::QueryArchetypes);
+    std::vector<DdsId> tables;
+    DdsResult result = archetypes(instance).query(componentCount, pComponents, tables);
+    if (result != DDS_RESULT_SUCCESS) {
+        return result;
+    }
+
+    if (pTables == nullptr) {
+        *pTableCount = tables.size();
+    } else {
+        *pTableCount = std::min<DdsSize>(*pTableCount, tables.size());
+        std::copy(tables.begin(), tables.begin() + *pTableCount, pTables);
+    }
+    return DDS_RESULT_SUCCESS;
+}
+
+DdsResult ddsGetStats(DdsStats *pEntries, DdsSize *pEntryCount) {
+#ifdef DDS_STATS
+    auto stats = dds::collectStats();
+    if (pEntries == nullptr) {
+        *pEntryCount = stats.size();
+        return DDS_RESULT_SUCCESS;
+    }
+
+    *pEntryCount = std::min<DdsSize>(*pEntryCount, stats.size());
+    for (size_t i = 0; i != *pEntryCount; ++i) {
+        auto const &stat = stats[i];
+        pEntries[i] = {dds::statName(stat.stat), stat.count, stat.totalNs, stat.minNs, stat.maxNs,
+                stat.p50Ns, stat.p90Ns, stat.p99Ns, stat.p999Ns};
+    }
+    return DDS_RESULT_SUCCESS;
+#else
+    (void) pEntries;
+    (void) pEntryCount;
+    return DDS_RESULT_NOT_SUPPORTED;
+#endif
+}
+
+DdsResult ddsResetStats() {
+#ifdef DDS_STATS
+    dds::resetStats();
+    return DDS_RESULT_SUCCESS;
+#else
+    return DDS_RESULT_NOT_SUPPORTED;
+#endif
+}
+
+DdsResult ddsStartTrace() {
+#ifdef DDS_STATS
+    dds::startTrace();
+    return DDS_RESULT_SUCCESS;
+#else
+    return DDS_RESULT_NOT_SUPPORTED;
+#endif
+}
+
+DdsResult ddsStopTrace(char const *path) {
+#ifdef DDS_STATS
+    return dds::stopTrace(path) ? DDS_RESULT_SUCCESS : DDS_RESULT_IO_ERROR;
+#else
+    (void) path;
+    return DDS_RESULT_NOT_SUPPORTED;
+#endif
+}
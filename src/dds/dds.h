@@ -18,6 +18,10 @@ typedef enum DdsResult {
     DDS_RESULT_ALREADY_CONNECTED,
     DDS_RESULT_NOT_CONNECTED,
     DDS_RESULT_CHILD_NOT_EXIST,
+    DDS_RESULT_IO_ERROR,
+    DDS_RESULT_IN_PROGRESS,
+    DDS_RESULT_NOT_SUPPORTED,
+    DDS_RESULT_OUT_OF_MEMORY,
 } DdsResult;
 
 typedef enum DdsTableType {
@@ -47,17 +51,97 @@ typedef enum DdsDataType {
     DDS_VEC4F_TYPE,
     DDS_MAT3F_TYPE,
     DDS_MAT4F_TYPE,
+    // Any length, the cells are DdsStringRef into a character heap per column. Values are passed
+    // to inserts, updates and ddsFind as one buffer of count + 1 DdsSize offsets followed by the
+    // characters, value i being the characters from offset i to offset i + 1, like Arrow.
+    DDS_STRING_TYPE,
 } DdsDataType;
 
 typedef struct DdsInstanceT DdsInstanceT;
 typedef DdsInstanceT *DdsInstance;
 
+typedef struct DdsSerializeJobT DdsSerializeJobT;
+typedef DdsSerializeJobT *DdsSerializeJob;
+
 typedef enum DdsInstanceCreateFlags {
     DDS_INSTANCE_CREATE_MMAP_WRITE = 0x00000001,
     DDS_INSTANCE_CREATE_MMAP_READ = 0x00000002,
+    // Logs every change to <file>.wal and replays it on create. A change is durable when its
+    // call returns, at the cost of one fdatasync per call. ddsFlushCommands and the entity calls
+    // sync once for all of their changes. ddsSerialize drops the logged changes it contains.
+    DDS_INSTANCE_CREATE_WAL = 0x00000004,
+    // file is a directory of manifest and segments, with MMAP_WRITE the segments are mapped as
+    // live storage that grows in place and ddsSerialize only flushes them
+    DDS_INSTANCE_CREATE_SEGMENTED = 0x00000008,
+    // with SEGMENTED only the manifest is read on create, table data on first access
+    DDS_INSTANCE_CREATE_LAZY = 0x00000010,
+    // without any mmap flag the file is mapped copy-on-write, HEAP copies it onto the heap instead
+    DDS_INSTANCE_CREATE_HEAP = 0x00000020,
 } DdsInstanceCreateFlags;
 
+typedef enum DdsAccessHint {
+    DDS_ACCESS_HINT_WILLNEED,
+    DDS_ACCESS_HINT_SEQUENTIAL,
+    DDS_ACCESS_HINT_RANDOM,
+} DdsAccessHint;
+
+typedef enum DdsSortOrder {
+    DDS_SORT_ASCENDING,
+    DDS_SORT_DESCENDING,
+} DdsSortOrder;
+
+typedef enum DdsImportFormat {
+    DDS_IMPORT_CSV, // vector and matrix columns take one field per component
+    // little endian values of every file column after each other, laid out as in memory
+    DDS_IMPORT_COLUMNAR,
+} DdsImportFormat;
+
+typedef struct DdsImportOptions {
+    char delimiter; // ',' when 0
+    uint32_t skipRows; // header lines of a csv file
+    DdsSize columnCount; // columns in the file, 0 for all columns of the table in id order
+    DdsId const *pColumns;
+} DdsImportOptions;
+
+typedef enum DdsMemoryKind {
+    DDS_MEMORY_COLUMN, // soa column buffer and string heap, id is the column
+    DDS_MEMORY_AOS_TABLE, // id is the table
+    DDS_MEMORY_ID_MAP, // value index built by ddsFind, id is the column
+    DDS_MEMORY_CONNECTION, // id is the child parent column
+    DDS_MEMORY_MULTI_CONNECTION, // id is the child parent column
+    DDS_MEMORY_LISTENER, // id is the table
+    DDS_MEMORY_CATALOG, // names, types and indexes of all tables and columns, id is 0
+} DdsMemoryKind;
+
+typedef struct DdsMemoryStats {
+    DdsMemoryKind kind;
+    DdsId id;
+    DdsSize usedBytes;
+    DdsSize reservedBytes; // capacity, reservedBytes - usedBytes is slack
+} DdsMemoryStats;
+
+typedef struct DdsMemoryTotals {
+    DdsSize usedBytes;
+    DdsSize reservedBytes;
+    DdsSize slackBytes;
+    DdsSize allocatorBytes; // held by table arenas and the index node pool
+    DdsSize fragmentationBytes; // allocator memory backing no live buffer or node
+} DdsMemoryTotals;
+
+typedef struct DdsStats {
+    char const *name; // entry point like "ddsInsert" or internal path like "index.build"
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t minNs;
+    uint64_t maxNs;
+    uint64_t p50Ns; // percentiles are upper bounds within 1/32 of the value
+    uint64_t p90Ns;
+    uint64_t p99Ns;
+    uint64_t p999Ns;
+} DdsStats;
+
 typedef enum DdsSerializeFlags {
+    DDS_SERIALIZE_FULL = 0x00000001, // rewrite segments of unchanged tables too
 } DdsSerializeFlags;
 
 DdsResult ddsCreateInstance(DdsInstanceCreateFlags flags, char const *file,
@@ -67,23 +151,54 @@ DdsResult ddsDeleteInstance(DdsInstance instance);
 
 DdsResult ddsSerialize(DdsInstance instance, DdsSerializeFlags flags);
 
+// Copies the instance data and serializes the copy from a background thread, changes made
+// meanwhile go to the next snapshot. The copy takes as much memory as the data. Not supported for
+// segmented instances.
+DdsResult ddsSerializeAsync(DdsInstance instance, DdsSerializeFlags flags,
+        DdsSerializeJob *pReturn);
+
+// DDS_RESULT_IN_PROGRESS while the snapshot is written, its result afterwards
+DdsResult ddsPollSerialize(DdsSerializeJob job);
+
+DdsResult ddsWaitSerialize(DdsSerializeJob job);
+
+// Waits for the job. A job may outlive its instance.
+DdsResult ddsDeleteSerializeJob(DdsSerializeJob job);
+
 DdsResult ddsCreateTable(DdsInstance instance, DdsTableType type, char const *name,
         DdsSize columnCount, char const *const *pColumnNames, DdsDataType const *pColumnTypes,
         DdsId *pReturn);
 
 DdsResult ddsDeleteTable(DdsInstance instance, DdsId table);
 
+DdsResult ddsPrefetchTable(DdsInstance instance, DdsId table, DdsAccessHint hint);
+
 DdsResult ddsFind(DdsInstance instance, DdsId column, DdsDataType type, void const *value,
         DdsId *pResult);
 
+// Connections must not form a cycle, DDS_RESULT_INVALID_DATA otherwise
 DdsResult ddsMakeConnection(DdsInstance instance, DdsId parentTable, DdsId childParentColumn,
         DdsConnectionType type);
 
 DdsResult ddsFindChild(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
         DdsId *pResult);
 
+// Child rows of a parent as one array, valid until the child or parent table changes. The count
+// is always returned, pResult may be null.
 DdsResult ddsFindChildren(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
-        DdsId const **pResult, DdsSize *pChildrenCount);
+        DdsRowIndex const **pResult, DdsSize *pChildrenCount);
+
+// Sorts the child table of a connection by the parent column, so the children of a parent are
+// one run of rows. Changes to the child or parent table are sorted in again by the next
+// ddsFlushCommands or ddsClusterChildren. DDS_RESULT_INVALID_DATA if parentTable is not the
+// parent of the connection.
+DdsResult ddsClusterChildren(DdsInstance instance, DdsId parentTable, DdsId childParentColumn);
+
+// First row and count of the children of a parent in a clustered child table, the rows can be
+// read straight from the column data. DDS_RESULT_INVALID_DATA while changes are not clustered
+// again.
+DdsResult ddsFindChildRange(DdsInstance instance, DdsId childParentColumn, DdsId parentId,
+        DdsId *pOffset, DdsSize *pCount);
 
 DdsResult ddsGetTablesCount(DdsInstance instance, DdsSize *pReturn);
 
@@ -102,16 +217,102 @@ DdsResult ddsGetColumnName(DdsInstance instance, DdsId column, char const **pRet
 
 DdsResult ddsGetColumnType(DdsInstance instance, DdsId column, DdsDataType *pReturn);
 
+// Byte offset of the column within a row of its aos table
+DdsResult ddsGetColumnOffset(DdsInstance instance, DdsId column, DdsSize *pReturn);
+
 DdsResult ddsInsert(DdsInstance instance, DdsId table, DdsSize count, DdsSize columnCount,
         DdsDataType const *pColumnTypes, DdsData const *pColumnData);
 
+// Appends count rows of an aos table given in its own row layout with a single copy. Tables with
+// DDS_STRING_TYPE columns take their rows through ddsInsert.
+DdsResult ddsInsertRows(DdsInstance instance, DdsId table, DdsSize count, DdsData rows);
+
+// Appends all rows of a file in one insert. pOptions may be null. Tables with DDS_STRING_TYPE
+// columns are imported with ddsImportArrow.
+DdsResult ddsImport(DdsInstance instance, DdsId table, DdsImportFormat format, char const *path,
+        DdsImportOptions const *pOptions);
+
+// Removing a row removes the rows connected to it as children, and their children in turn
 DdsResult ddsRemove(DdsInstance instance, DdsId table, DdsId position);
 
+// Removes rows given by their positions before the call, duplicates are removed once. Children
+// of removed rows are collected across all connections first and removed in one batch per table.
+DdsResult ddsRemoveRows(DdsInstance instance, DdsId table, DdsSize count,
+        DdsId const *pPositions);
+
+// Reorders the rows of a table by the key columns, the first key deciding first. The sort is
+// stable, numeric and string keys are supported. Indices and connections are updated, row
+// positions held by deferred commands are not.
+DdsResult ddsSortTable(DdsInstance instance, DdsId table, DdsSize keyCount,
+        DdsId const *pKeyColumns, DdsSortOrder order);
+
 DdsResult ddsColumnData(DdsInstance instance, DdsId column, DdsDataType type,
         DdsColumnData *pResult);
 
 DdsResult ddsAosData(DdsInstance instance, DdsId column, DdsData *pResult);
 
+// Characters of a DDS_STRING_TYPE column the cells point into, valid until the table changes
+DdsResult ddsStringHeap(DdsInstance instance, DdsId column, DdsData *pResult);
+
+// pTotals may be null. With pEntries null only the entry count is returned, otherwise up to
+// *pEntryCount entries are written and *pEntryCount is set to their number.
+DdsResult ddsGetMemoryStats(DdsInstance instance, DdsMemoryTotals *pTotals,
+        DdsMemoryStats *pEntries, DdsSize *pEntryCount);
+
+// Deferred commands are recorded into a buffer of the calling thread without locking and applied
+// by ddsFlushCommands ordered by sortKey. Positions refer to rows before the flush.
+DdsResult ddsRecordInsert(DdsInstance instance, DdsId table, DdsId sortKey, DdsSize count,
+        DdsSize columnCount, DdsDataType const *pColumnTypes, DdsData const *pColumnData);
+
+DdsResult ddsRecordRemove(DdsInstance instance, DdsId table, DdsId sortKey, DdsId position);
+
+DdsResult ddsRecordUpdate(DdsInstance instance, DdsId column, DdsId sortKey, DdsId position,
+        DdsDataType type, void const *pValue);
+
+// Recorded commands are dropped even when the flush fails. Nothing is applied when an update or
+// remove refers to a row that does not exist.
+DdsResult ddsFlushCommands(DdsInstance instance);
+
+// Entities are rows of archetype tables, one soa table per set of components named
+// "archetype:" followed by the component names. The tables are managed by these calls and can
+// be read like any other, an entity column comes first. Component names must not contain ','.
+DdsResult ddsRegisterComponent(DdsInstance instance, char const *name, DdsDataType type,
+        DdsId *pReturn);
+
+// pValues holds per component the values of all count entities
+DdsResult ddsCreateEntities(DdsInstance instance, DdsSize count, DdsSize componentCount,
+        DdsId const *pComponents, void const *const *pValues, DdsEntity *pReturn);
+
+DdsResult ddsDestroyEntities(DdsInstance instance, DdsSize count, DdsEntity const *pEntities);
+
+// Moves the entities to the archetypes with the component added, pValues holds count values
+DdsResult ddsAddComponent(DdsInstance instance, DdsSize count, DdsEntity const *pEntities,
+        DdsId component, void const *pValues);
+
+DdsResult ddsRemoveComponent(DdsInstance instance, DdsSize count, DdsEntity const *pEntities,
+        DdsId component);
+
+// Table and row of an entity, valid until the next change of the archetype layer
+DdsResult ddsGetEntity(DdsInstance instance, DdsEntity entity, DdsId *pTable, DdsId *pRow);
+
+// Tables of all archetypes having every given component. With pTables null only the count is
+// returned.
+DdsResult ddsQueryArchetypes(DdsInstance instance, DdsSize componentCount,
+        DdsId const *pComponents, DdsId *pTables, DdsSize *pTableCount);
+
+// Latencies of every entry point and internal path called so far, merged over all threads of the
+// process. DDS_RESULT_NOT_SUPPORTED unless the library is built with the stats option. Entries
+// are returned like by ddsGetMemoryStats.
+DdsResult ddsGetStats(DdsStats *pEntries, DdsSize *pEntryCount);
+
+DdsResult ddsResetStats(void);
+
+// Records every measured call until ddsStopTrace writes them as Chrome trace events, which
+// chrome://tracing and Perfetto open
+DdsResult ddsStartTrace(void);
+
+DdsResult ddsStopTrace(char const *path);
+
 #ifdef __cplusplus
 }
 #endif
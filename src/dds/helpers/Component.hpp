@@ -5,6 +5,8 @@
 #include <cista/reflection/to_tuple.h>
 #include <cstdint>
 #include <cassert>
+#include <limits>
+#include <tuple>
 #include "Range.hpp"
 #include "generic.hpp"
 
@@ -61,6 +63,10 @@ namespace dds {
             removeCallbacks.emplace_back(f);
         }
 
+        // rows of a component are never reordered
+        template<typename FnT>
+        void onPermute(FnT &&) {}
+
     private:
         bool check_valid() const {
             size_t prevSize = std::get<0>(val).size();
@@ -1,15 +1,21 @@
 #pragma once
 #include <cstdint>
+#include <limits>
 #include <vector>
 #include <optional>
 #include "dds/helpers/generic.hpp"
+#include "dds/helpers/memory.hpp"
+#include "dds/types.h"
+#include <limits>
 
 namespace dds {
     class Connection {
     public:
+        // parentCount is the row count of the parent table
         template<typename T1, typename C1, typename C2>
-        explicit Connection(C1 &childConnection, T1 &childParentMember, C2 &parentConnection) {
-            parentChild.resize(childParentMember.size(), notExist);
+        explicit Connection(C1 &childConnection, T1 &childParentMember, C2 &parentConnection,
+                size_t parentCount) {
+            parentChild.resize(parentCount, notExist);
             for (size_t i = 0; i != childParentMember.size(); ++i) {
                 parentChild[childParentMember[i]] = i;
             }
@@ -22,18 +28,45 @@ namespace dds {
 
             childConnection.onRemove([this, &childParentMember](size_t pos) {
                 parentChild[childParentMember[pos]] = notExist;
-                parentChild[childParentMember.back()] = pos;
+                if (pos != childParentMember.size() - 1) {
+                    parentChild[childParentMember.back()] = pos;
+                }
+            });
+
+            childConnection.onPermute([this, &childParentMember](std::vector<size_t> const &) {
+                for (size_t i = 0; i != childParentMember.size(); ++i) {
+                    parentChild[childParentMember[i]] = i;
+                }
             });
 
             parentConnection.onInsert([this](size_t count) {
                 parentChild.resize(parentChild.size() + count, notExist);
             });
 
+            // Components remove the child here, ddsRemove removes the children of table rows
+            // before their parents
             parentConnection.onRemove([this, &childParentMember, &childConnection](size_t pos) {
-                        childParentMember[parentChild.back()] = pos;
+                if constexpr (CanRemove<C1>::value) {
+                    if (parentChild[pos] != notExist) {
                         childConnection.remove(parentChild[pos]);
-                        unstableRemove(parentChild, pos);
-                    });
+                    }
+                }
+                if (parentChild.back() != notExist) {
+                    childParentMember[parentChild.back()] = pos;
+                }
+                unstableRemove(parentChild, pos);
+            });
+
+            // children keep their parents, which moved
+            parentConnection.onPermute([this, &childParentMember](
+                    std::vector<size_t> const &order) {
+                for (size_t i = 0; i != order.size(); ++i) {
+                    if (parentChild[order[i]] != notExist) {
+                        childParentMember[parentChild[order[i]]] = i;
+                    }
+                }
+                permute(parentChild, order);
+            });
         }
 
         std::optional<size_t> operator[](size_t parent) const {
@@ -44,8 +77,12 @@ namespace dds {
             }
         }
 
+        MemoryUsage memoryUsage() const {
+            return vectorUsage(parentChild);
+        }
+
     private:
-        static const size_t notExist = std::numeric_limits<size_t>::max();
-        std::vector<size_t> parentChild;
+        static constexpr DdsRowIndex notExist = std::numeric_limits<DdsRowIndex>::max();
+        std::vector<DdsRowIndex> parentChild;
     };
 }
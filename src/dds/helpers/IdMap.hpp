@@ -1,9 +1,12 @@
 #pragma once
 
+#include "dds/data/allocator.hpp"
+#include "dds/helpers/memory.hpp"
+#include "dds/types.h"
 #include <cstdint>
+#include <functional>
 #include <unordered_map>
 #include <optional>
-#include <cassert>
 
 namespace dds {
     template<typename T>
@@ -11,35 +14,107 @@ namespace dds {
     public:
         IdMap() = delete;
 
+        // nodes come from pPool when it is set
         template<typename CT, typename T1>
-        explicit IdMap(CT &connection, T1 & member) {
+        explicit IdMap(CT &connection, T1 & member, SizeClassPool *pPool = nullptr)
+                : map(0, std::hash<T>{}, std::equal_to<T>{}, Allocator(pPool)) {
+            // first row other than skip holding value, member.size() if there is none
+            findFirst = [&member](T const &value, size_t skip) {
+                for (size_t i = 0; i != member.size(); ++i) {
+                    if (i != skip && member[i] == value) {
+                        return i;
+                    }
+                }
+                return member.size();
+            };
             for (size_t i = 0; i != member.size(); ++i) {
-                map.emplace(member[i], i);
+                add(member[i], i);
             }
             connection.onInsert([this, &member](size_t count) {
                 for (size_t i = member.size() - count; i != member.size(); ++i) {
-                    map.emplace(member[i], i);
+                    add(member[i], i);
                 }
             });
+            // runs before the last row is moved to the removed one
             connection.onRemove([this, &member](size_t to) {
-                auto iter = map.find(member.back());
-                assert(iter != map.end() && "member no found");
-                iter->second = to;
-                map.erase(member[to]);
+                size_t last = member.size() - 1;
+                drop(member[to], to);
+                if (to != last) {
+                    auto iter = map.find(member.back());
+                    if (iter != map.end() && to < iter->second.row) {
+                        iter->second.row = to;
+                    }
+                }
+            });
+            // duplicates map to their first row, as when the map was built
+            connection.onPermute([this, &member](std::vector<size_t> const &) {
+                for (size_t i = member.size(); i-- != 0;) {
+                    auto iter = map.find(member[i]);
+                    if (iter != map.end()) {
+                        iter->second.row = i;
+                    }
+                }
             });
         }
 
+        // Value at pos is about to be overwritten in place, the member still holds the old value
+        void replace(T const &oldValue, T const &newValue, size_t pos) {
+            if (oldValue == newValue) {
+                return;
+            }
+            drop(oldValue, pos);
+            add(newValue, pos);
+        }
+
         std::optional<size_t> operator[](T const& v) const {
             auto iter = map.find(v);
             if (iter != map.end()) {
-                return iter->second;
+                return iter->second.row;
             } else {
                 return {};
             }
         }
 
+        // Nodes are estimated as value and next pointer, buckets as one pointer each
+        MemoryUsage memoryUsage() const {
+            size_t valueSize = sizeof(typename decltype(map)::value_type);
+            return {map.size() * valueSize,
+                    map.size() * (valueSize + sizeof(void *)) + map.bucket_count() * sizeof(void *)};
+        }
+
     private:
-        std::unordered_map<T, size_t> map;
+        // first row holding the value and the number of rows holding it
+        struct Rows {
+            DdsRowIndex row;
+            DdsRowIndex count;
+        };
+
+        using Allocator = PoolAllocator<std::pair<T const, Rows>>;
+
+        void add(T const &value, size_t pos) {
+            auto iter = map.try_emplace(value, Rows{static_cast<DdsRowIndex>(pos), 0}).first;
+            ++iter->second.count;
+            if (pos < iter->second.row) {
+                iter->second.row = pos;
+            }
+        }
+
+        // Another holder of a duplicate takes over when pos was its first row, found by a scan
+        // of the member
+        void drop(T const &value, size_t pos) {
+            auto iter = map.find(value);
+            if (iter == map.end()) {
+                return;
+            }
+            if (--iter->second.count == 0) {
+                map.erase(iter);
+            } else if (iter->second.row == pos) {
+                iter->second.row = findFirst(value, pos);
+            }
+        }
+
+        std::unordered_map<T, Rows, std::hash<T>, std::equal_to<T>, Allocator> map;
+        std::function<size_t(T const &, size_t)> findFirst;
     };
 
     template<typename CT, typename T>
@@ -1,50 +1,212 @@
 #pragma once
 
+#include "dds/helpers/generic.hpp"
+#include "dds/helpers/memory.hpp"
+#include "dds/types.h"
+#include <algorithm>
 #include <cstdint>
 #include <vector>
 
 namespace dds {
-    class MultiConnection {
+    // Children of one parent, contiguous until the connection changes
+    template<typename Index>
+    class ChildSpan {
     public:
+        ChildSpan(Index const *pData, size_t count) : pData(pData), count(count) {}
+
+        Index const *data() const {
+            return pData;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        Index const *begin() const {
+            return pData;
+        }
+
+        Index const *end() const {
+            return pData + count;
+        }
+
+        size_t operator[](size_t i) const {
+            return pData[i];
+        }
+
+    private:
+        Index const *pData;
+        size_t count;
+    };
+
+    // Children of all parents in one array, a parent's segment at offsets[parent]. Built compact
+    // in parent order. A parent whose segment is full moves it behind the others with room to
+    // grow, the dead segments are dropped by a merge once they take as much as the live ones.
+    // Children and counts are stored as Index, offsets as size_t since the slack may take the
+    // array past the range of the row positions.
+    template<typename Index>
+    class BasicMultiConnection {
+    public:
+        // parentCount is the row count of the parent table, the children only say which
+        // parents have any
         template<typename T1, typename C1, typename C2>
-        explicit MultiConnection(C1 &childConnection, T1 &childParentMember, C2 &parentConnection) {
-            parentChildren.resize(childParentMember.size());
+        explicit BasicMultiConnection(C1 &childConnection, T1 &childParentMember,
+                C2 &parentConnection, size_t parentCount) {
+            offsets.resize(parentCount);
+            counts.resize(parentCount);
+            for (size_t i = 0; i != childParentMember.size(); ++i) {
+                ++counts[childParentMember[i]];
+            }
+            for (size_t parent = 0, offset = 0; parent != parentCount; ++parent) {
+                offsets[parent] = offset;
+                offset += counts[parent];
+            }
+            capacities = counts;
+
+            children.resize(childParentMember.size());
+            std::vector<Index> filled(parentCount);
             for (size_t i = 0; i != childParentMember.size(); ++i) {
-                parentChildren[childParentMember[i]].push_back(i);
+                size_t parent = childParentMember[i];
+                children[offsets[parent] + filled[parent]++] = i;
             }
+            childCount = children.size();
 
             childConnection.onInsert([this, &childParentMember](size_t count) {
                 for (size_t i = childParentMember.size() - count;
                      i != childParentMember.size(); ++i) {
-                    parentChildren[childParentMember[i]].push_back(i);
+                    append(childParentMember[i], i);
                 }
+                mergeIfSparse();
             });
 
             childConnection.onRemove([this, &childParentMember](size_t pos) {
-                unstableRemoveValue(parentChildren[childParentMember[pos]], pos);
-                auto &backChildren = parentChildren[childParentMember.back()];
-                *std::find(backChildren.begin(), backChildren.end(),
-                        childParentMember.size() - 1) = pos;
+                erase(childParentMember[pos], pos);
+                size_t last = childParentMember.size() - 1;
+                if (pos != last) {
+                    *find(childParentMember.back(), last) = pos;
+                }
+            });
+
+            childConnection.onPermute([this](std::vector<size_t> const &order) {
+                std::vector<size_t> position(order.size());
+                for (size_t i = 0; i != order.size(); ++i) {
+                    position[order[i]] = i;
+                }
+                for (size_t parent = 0; parent != offsets.size(); ++parent) {
+                    auto beg = children.begin() + offsets[parent];
+                    for (auto iter = beg; iter != beg + counts[parent]; ++iter) {
+                        *iter = position[*iter];
+                    }
+                }
             });
 
             parentConnection.onInsert([this](size_t count) {
-                parentChildren.resize(parentChildren.size() + count);
+                offsets.resize(offsets.size() + count, children.size());
+                counts.resize(counts.size() + count);
+                capacities.resize(capacities.size() + count);
             });
 
+            // Components remove the children here, highest row first so the rows moved into
+            // their places are never ones still to be removed. ddsRemove removes the children of
+            // table rows before their parents.
             parentConnection.onRemove([this, &childParentMember, &childConnection](size_t pos) {
-                for (size_t i = 0; i != parentChildren.size(); ++i) {
-                    childParentMember[parentChildren.back()[i]] = pos;
-                    childConnection.remove(parentChildren[pos][i]);
-                    unstableRemove(parentChildren, pos);
+                if constexpr (CanRemove<C1>::value) {
+                    std::vector<size_t> removed((*this)[pos].begin(), (*this)[pos].end());
+                    std::sort(removed.rbegin(), removed.rend());
+                    for (size_t child : removed) {
+                        childConnection.remove(child);
+                    }
+                }
+
+                for (size_t child : (*this)[offsets.size() - 1]) {
+                    childParentMember[child] = pos;
+                }
+                unstableRemove(offsets, pos);
+                unstableRemove(counts, pos);
+                unstableRemove(capacities, pos);
+            });
+
+            parentConnection.onPermute([this, &childParentMember](
+                    std::vector<size_t> const &order) {
+                for (size_t i = 0; i != order.size(); ++i) {
+                    for (size_t child : (*this)[order[i]]) {
+                        childParentMember[child] = i;
+                    }
                 }
+                permute(offsets, order);
+                permute(counts, order);
+                permute(capacities, order);
             });
         }
 
-        std::vector<size_t> const &operator[](size_t parent) const {
-            return parentChildren[parent];
+        ChildSpan<Index> operator[](size_t parent) const {
+            return {children.data() + offsets[parent], counts[parent]};
+        }
+
+        MemoryUsage memoryUsage() const {
+            MemoryUsage result = vectorUsage(children);
+            result += vectorUsage(offsets);
+            result += vectorUsage(counts);
+            result += vectorUsage(capacities);
+            return result;
         }
 
     private:
-        std::vector<std::vector<size_t>> parentChildren;
+        static constexpr Index minCapacity = 4;
+        static constexpr size_t mergeSlack = 4096;
+
+        Index *find(size_t parent, size_t child) {
+            auto beg = children.begin() + offsets[parent];
+            return &*std::find(beg, beg + counts[parent], child);
+        }
+
+        void append(size_t parent, size_t child) {
+            if (counts[parent] == capacities[parent]) {
+                Index capacity = std::max<Index>(minCapacity, 2 * counts[parent]);
+                size_t offset = children.size();
+                children.resize(offset + capacity);
+                std::copy_n(children.begin() + offsets[parent], counts[parent],
+                        children.begin() + offset);
+                offsets[parent] = offset;
+                capacities[parent] = capacity;
+            }
+            children[offsets[parent] + counts[parent]++] = child;
+            ++childCount;
+        }
+
+        // the last child of the segment takes the place of the removed one
+        void erase(size_t parent, size_t child) {
+            *find(parent, child) = children[offsets[parent] + counts[parent] - 1];
+            --counts[parent];
+            --childCount;
+        }
+
+        void mergeIfSparse() {
+            if (children.size() <= 2 * childCount + mergeSlack) {
+                return;
+            }
+
+            std::vector<Index> merged;
+            merged.reserve(childCount);
+            for (size_t parent = 0; parent != offsets.size(); ++parent) {
+                auto beg = children.begin() + offsets[parent];
+                offsets[parent] = merged.size();
+                merged.insert(merged.end(), beg, beg + counts[parent]);
+            }
+            capacities = counts;
+            children.swap(merged);
+        }
+
+        std::vector<Index> children;
+        std::vector<size_t> offsets;
+        std::vector<Index> counts;
+        std::vector<Index> capacities;
+        size_t childCount = 0;
     };
+
+    using MultiConnection = BasicMultiConnection<DdsRowIndex>;
 }
@@ -64,18 +64,18 @@ namespace dds {
 
         using value_type = T;
 
-        using iterator = T *;
+        using iterator = StrideIterator<T>;
 
         iterator begin() const {
-            return StrideIterator<T>(data->begin() + offset, stride);
+            return StrideIterator<T>(data->data() + offset, stride);
         }
 
         iterator end() const {
-            return StrideIterator<T>(data->end() + offset, stride);
+            return StrideIterator<T>(data->data() + data->size() + offset, stride);
         }
 
         size_t size() const {
-            return begin() - end();
+            return end() - begin();
         }
 
         value_type front() const {
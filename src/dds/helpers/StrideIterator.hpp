@@ -1,81 +1,111 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <type_traits>
 
 namespace dds {
+    // Iterates values stride bytes apart, like one column of aos rows
     template<typename T>
     class StrideIterator {
-        friend bool operator==(const StrideIterator &lhs, const StrideIterator &rhs) {
-            return lhs.pData == rhs.pData &&
-                   lhs.stride == rhs.stride;
-        }
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::remove_cv_t<T>;
+        using pointer = T *;
+        using reference = T &;
 
-        friend bool operator!=(const StrideIterator &lhs, const StrideIterator &rhs) {
-            return !(rhs == lhs);
-        }
+        StrideIterator() = default;
 
-        friend StrideIterator operator+(StrideIterator lhs, size_t rhs) {
-            return lhs += rhs;
-        }
+        StrideIterator(uint8_t *pData, size_t stride) : pData(pData), stride(stride) {}
 
-        friend StrideIterator operator-(StrideIterator lhs, size_t rhs) {
-            return lhs -= rhs;
+        T &operator*() const {
+            return *reinterpret_cast<T *>(pData);
         }
 
-        friend size_t operator-(StrideIterator lhs, StrideIterator rhs) {
-            assert(lhs.stride == rhs.stride);
-            return (reinterpret_cast<uint8_t *>(lhs.pData)
-            - reinterpret_cast<uint8_t *>(rhs.pData)) / lhs.stride;
+        T *operator->() const {
+            return reinterpret_cast<T *>(pData);
         }
 
-    public:
-        using iterator_category = std::random_access_iterator_tag;
-        using difference_type   = std::ptrdiff_t;
-        using value_type        = T;
-        using pointer           = T*;  // or also value_type*
-        using reference         = T&;
-
-        explicit StrideIterator(void *pData, size_t stride) : pData(pData), stride(stride) {}
-
-        T &operator*() const {
-            return *(reinterpret_cast<T *>(pData));
+        T &operator[](difference_type i) const {
+            return *(*this + i);
         }
 
         StrideIterator &operator++() {
-            pData = reinterpret_cast<uint8_t *>(pData) + stride;
+            pData += stride;
             return *this;
         }
 
         StrideIterator operator++(int) {
-            StrideIterator copy = *this;
-            pData = reinterpret_cast<uint8_t *>(pData) + stride;
-            return copy;
+            StrideIterator result = *this;
+            ++*this;
+            return result;
         }
 
         StrideIterator &operator--() {
-            pData = reinterpret_cast<uint8_t *>(pData) - stride;
+            pData -= stride;
             return *this;
         }
 
         StrideIterator operator--(int) {
-            StrideIterator copy = *this;
-            pData = reinterpret_cast<uint8_t *>(pData) - stride;
-            return copy;
+            StrideIterator result = *this;
+            --*this;
+            return result;
         }
 
-        StrideIterator &operator+=(size_t i) {
-            pData = reinterpret_cast<uint8_t *>(pData) + stride * i;
+        StrideIterator &operator+=(difference_type i) {
+            pData += i * static_cast<difference_type>(stride);
             return *this;
         }
 
-        StrideIterator &operator-=(size_t i) {
-            pData = reinterpret_cast<uint8_t *>(pData) - stride * i;
-            return *this;
+        StrideIterator &operator-=(difference_type i) {
+            return *this += -i;
+        }
+
+        friend StrideIterator operator+(StrideIterator iter, difference_type i) {
+            return iter += i;
+        }
+
+        friend StrideIterator operator+(difference_type i, StrideIterator iter) {
+            return iter += i;
+        }
+
+        friend StrideIterator operator-(StrideIterator iter, difference_type i) {
+            return iter -= i;
+        }
+
+        // both iterate the same values
+        friend difference_type operator-(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return (lhs.pData - rhs.pData) / static_cast<difference_type>(lhs.stride);
+        }
+
+        friend bool operator==(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return lhs.pData == rhs.pData;
+        }
+
+        friend bool operator!=(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return lhs.pData != rhs.pData;
+        }
+
+        friend bool operator<(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return lhs.pData < rhs.pData;
+        }
+
+        friend bool operator>(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return rhs < lhs;
+        }
+
+        friend bool operator<=(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return !(rhs < lhs);
+        }
+
+        friend bool operator>=(StrideIterator const &lhs, StrideIterator const &rhs) {
+            return !(lhs < rhs);
         }
 
     private:
-        void *pData;
-        size_t stride;
+        uint8_t *pData = nullptr;
+        size_t stride = 0;
     };
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include "dds/helpers/memory.hpp"
 #include <cstdint>
 
 namespace dds {
@@ -14,6 +15,11 @@ namespace dds {
             removeCallbacks.emplace_back(f);
         }
 
+        template<typename FnT>
+        void onPermute(FnT && f) {
+            permuteCallbacks.emplace_back(f);
+        }
+
         void doInsert(size_t count) {
             for(auto const& f : insertCallbacks) {
                 f(count);
@@ -26,8 +32,24 @@ namespace dds {
             }
         }
 
+        void doPermute(std::vector<size_t> const &order) {
+            for(auto const& f : permuteCallbacks) {
+                f(order);
+            }
+        }
+
+        // without the state captured by the callbacks
+        MemoryUsage memoryUsage() const {
+            MemoryUsage result = vectorUsage(insertCallbacks);
+            result += vectorUsage(removeCallbacks);
+            result += vectorUsage(permuteCallbacks);
+            return result;
+        }
+
     private:
         std::vector<std::function<void(size_t count)>> insertCallbacks; // after insert
         std::vector<std::function<void(size_t pos)>> removeCallbacks; // below remove
+        // after the rows moved, order[i] is the old position of row i
+        std::vector<std::function<void(std::vector<size_t> const &order)>> permuteCallbacks;
     };
 }
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace dds {
+    // granularity of segment file checksums, blocks are hashed and verified independently
+    inline constexpr size_t checksumBlockSize = 1024 * 1024;
+
+    namespace detail {
+        constexpr std::array<uint32_t, 256> makeCrc32Table() {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t i = 0; i != 256; ++i) {
+                uint32_t crc = i;
+                for (int j = 0; j != 8; ++j) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                table[i] = crc;
+            }
+            return table;
+        }
+
+        inline constexpr std::array<uint32_t, 256> crc32Table = makeCrc32Table();
+    }
+
+    // CRC-32 (IEEE). Pass the previous result as seed to continue a checksum.
+    inline uint32_t crc32(void const *pData, size_t size, uint32_t seed = 0) {
+        auto p = static_cast<uint8_t const *>(pData);
+        uint32_t crc = ~seed;
+        for (size_t i = 0; i != size; ++i) {
+            crc = detail::crc32Table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+}
@@ -2,6 +2,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 namespace dds {
     template<typename C, typename T>
@@ -32,4 +35,22 @@ namespace dds {
         unstableRemove(c, *index);
     }
 
+    // Moves c[order[i]] to i
+    template<typename Cnt>
+    void permute(Cnt &c, std::vector<size_t> const &order) {
+        Cnt sorted;
+        sorted.reserve(order.size());
+        for (size_t index : order) {
+            sorted.push_back(c[index]);
+        }
+        c = std::move(sorted);
+    }
+
+    // Listeners that remove their own rows, like the catalog components
+    template<typename C, typename = void>
+    struct CanRemove : std::false_type {};
+
+    template<typename C>
+    struct CanRemove<C, std::void_t<decltype(std::declval<C &>().remove(size_t{}))>>
+            : std::true_type {};
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace dds {
+    struct MemoryUsage {
+        size_t used = 0;
+        size_t reserved = 0;
+
+        MemoryUsage &operator+=(MemoryUsage const &other) {
+            used += other.used;
+            reserved += other.reserved;
+            return *this;
+        }
+    };
+
+    template<typename C>
+    MemoryUsage vectorUsage(C const &c) {
+        using T = typename C::value_type;
+        return {c.size() * sizeof(T), c.capacity() * sizeof(T)};
+    }
+}
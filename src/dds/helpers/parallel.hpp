@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace dds {
+    // Calls f(i) for every i in [0, count) on up to one thread per hardware thread, the calling
+    // thread included. Items are handed out one at a time, so they may differ in cost.
+    template<typename F>
+    void parallelFor(size_t count, F &&f) {
+        size_t threadCount = std::min<size_t>(count,
+                std::max(1u, std::thread::hardware_concurrency()));
+        if (threadCount <= 1) {
+            for (size_t i = 0; i != count; ++i) {
+                f(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next{0};
+        auto worker = [&] {
+            for (size_t i = next++; i < count; i = next++) {
+                f(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i != threadCount; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dds {
+    // First of a, b or c in [p, end), end when there is none. Compares 16 bytes at a time
+    // where SSE2 is available.
+    inline char const *findAny(char const *p, char const *end, char a, char b, char c) {
+#if defined(__SSE2__)
+        __m128i va = _mm_set1_epi8(a);
+        __m128i vb = _mm_set1_epi8(b);
+        __m128i vc = _mm_set1_epi8(c);
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va),
+                    _mm_cmpeq_epi8(chunk, vb)), _mm_cmpeq_epi8(chunk, vc));
+            if (int mask = _mm_movemask_epi8(eq)) {
+                return p + __builtin_ctz(static_cast<unsigned>(mask));
+            }
+        }
+#endif
+        for (; p != end; ++p) {
+            if (*p == a || *p == b || *p == c) {
+                return p;
+            }
+        }
+        return end;
+    }
+
+    inline char const *findByte(char const *p, char const *end, char c) {
+        return findAny(p, end, c, c, c);
+    }
+
+    inline size_t countByte(char const *p, char const *end, char c) {
+        size_t result = 0;
+#if defined(__SSE2__)
+        __m128i vc = _mm_set1_epi8(c);
+        for (; end - p >= 16; p += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+            auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, vc)));
+            result += static_cast<size_t>(__builtin_popcount(mask));
+        }
+#endif
+        for (; p != end; ++p) {
+            result += *p == c;
+        }
+        return result;
+    }
+}
@@ -8,6 +8,22 @@ extern "C" {
 typedef uint64_t DdsId;
 typedef uint64_t DdsSize;
 typedef uint8_t DdsByte;
+typedef uint64_t DdsEntity;
+
+// Row positions held by indices and connections, 32 bit with the compact_index build option
+#ifdef DDS_COMPACT_INDEX
+typedef uint32_t DdsRowIndex;
+#else
+typedef uint64_t DdsRowIndex;
+#endif
+
+// Offsets into the character heap of DDS_STRING_TYPE columns, 32 bit with the compact_index
+// build option
+#ifdef DDS_COMPACT_INDEX
+typedef uint32_t DdsStringOffset;
+#else
+typedef uint64_t DdsStringOffset;
+#endif
 
 typedef struct DdsString16 {
     DdsSize length;
@@ -24,6 +40,12 @@ typedef struct DdsString256 {
     char str[256];
 } DdsString256;
 
+// Cell of a DDS_STRING_TYPE column, the characters are in the heap of the column
+typedef struct DdsStringRef {
+    DdsStringOffset offset;
+    DdsStringOffset length;
+} DdsStringRef;
+
 typedef struct DdsVec2F {
     float x;
     float y;